@@ -0,0 +1,58 @@
+#ifndef ALLOC_COUNTER_HPP
+#define ALLOC_COUNTER_HPP
+
+// Counts heap allocations, to check that code meant to be allocation-free is
+// (see Estimator::GetAllocationHistory())
+// Only counts when built with -DKARLGP_COUNT_ALLOCATIONS, which replaces the global operator new,
+// so it has to be defined in a single translation unit (like the globals in *_global.hpp)
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <cstddef>
+#include <algorithm>
+
+class AllocationCounter {
+private:
+    static inline std::atomic<size_t> count {0};
+
+public:
+    static constexpr bool enabled {
+#ifdef KARLGP_COUNT_ALLOCATIONS
+        true
+#else
+        false
+#endif
+    };
+
+    // Allocations so far, on all threads (always 0 when not enabled)
+    static size_t Count() { return count.load(std::memory_order_relaxed); }
+    static void Add() { count.fetch_add(1, std::memory_order_relaxed); }
+};
+
+#ifdef KARLGP_COUNT_ALLOCATIONS
+// The array and nothrow versions forward to these
+void * operator new(std::size_t size) {
+    AllocationCounter::Add();
+    if (void * p {std::malloc(size == 0 ? 1 : size)}) return p;
+    throw std::bad_alloc();
+}
+void * operator new(std::size_t size, std::align_val_t align) {
+    AllocationCounter::Add();
+    size_t const a {static_cast<size_t>(align)};
+    if (void * p {std::aligned_alloc(a, (std::max<size_t>(size, 1) + a - 1) / a * a)}) return p;
+    throw std::bad_alloc();
+}
+
+// Once these are inlined, GCC sees free() called on memory from operator new and can't tell
+// that the operator new it came from is the one above, which uses malloc()
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void * p) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t) noexcept { std::free(p); }
+void operator delete(void * p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+#endif
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef BASE_EVAL_HPP
 #define BASE_EVAL_HPP
 
+#include <memory>
+
 class Program;
 
 class Evaluator {
@@ -9,6 +11,20 @@ public:
     // Must implement in subclasses
     virtual emp::vector<double> GetInputSet() const = 0;
     virtual double Evaluate(Program & ) const = 0;
+
+    // Fitness of every program, in order, written into 'fitnesses' (its storage is reused)
+    // Evaluators that can share work across programs (e.g., MSE's blocked mode) override this
+    virtual void EvaluatePopulation(emp::vector<std::unique_ptr<Program>> const & population,
+        emp::vector<double> & fitnesses) const {
+        fitnesses.clear();
+        for (std::unique_ptr<Program> const & p : population) {
+            fitnesses.push_back(Evaluate(*p));
+        }
+    }
+
+    // Whether fitness only depends on the program's outputs (and not, e.g., on the rest of the
+    // population), so the Estimator can reuse it for programs with the same CanonicalHash()
+    virtual bool IsCacheable() const { return true; }
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
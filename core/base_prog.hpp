@@ -1,11 +1,41 @@
 #ifndef BASE_PROG_HPP
 #define BASE_PROG_HPP
 
+#include <span>
 #include <memory>
+#include <cstdint>
+#include <algorithm>
 
 #include "instructions.hpp"
 #include "base_eval.hpp"
 
+// How a program runs its (effective) instructions
+enum class ExecutionEngine {
+    INTERPRETER, // switch over each instruction's fields
+    THREADED, // compiled once into a chain of specialized handlers (see threaded_code.hpp)
+    JIT // compiled once into native x86-64 code (see jit.hpp), falls back to INTERPRETER if it can't be
+};
+
+// Where a domain's inputs and output live, and how its registers behave between runs
+struct RegisterLayout {
+    size_t input_begin; // inputs go in r[input_begin, input_begin + input_count)
+    size_t input_count;
+    size_t output; // output register
+    // If set, registers keep their values from one run to the next (e.g., the steps of a maze
+    // simulation) and only the inputs are overwritten. Otherwise registers are reset before each run.
+    bool carry_registers;
+    bool ternary; // InitProgram() generates ternary instructions (if there are ternary operators)
+
+    size_t MinRegisterCount() const { return std::max(output + 1, input_begin + input_count); }
+    bool IsInput(size_t r) const { return r >= input_begin && r < input_begin + input_count; }
+};
+
+// Instructions a shared batch run executed, vs. running each program on its own
+// (both 0 when the programs couldn't share work)
+struct SharedBatchStats {
+    size_t executed {0};
+    size_t naive {0};
+};
 
 class Program {
 public:
@@ -14,11 +44,48 @@ public:
     // Necessary for polymorphism
     virtual std::unique_ptr<Program> Clone() const = 0;
     virtual std::unique_ptr<Program> New() const = 0;
+    // Becomes a copy of 'other', which must be of the same class, reusing this program's storage:
+    // Clone() without the allocation
+    virtual void Assign(Program const & other) = 0;
     // virtual void SetEvaluator(Evaluator * evaluator) = 0;
 
     virtual void InitProgram() = 0;
     virtual double ExecuteProgram() = 0;
 
+    // Runs the program once per input, from freshly reset registers, and stores each raw
+    // output (what ExecuteProgram() returns) in 'outputs' (which must hold 'n' values).
+    // Programs that can run all inputs at once (e.g., ArithmeticProgram) override this.
+    virtual void ExecuteProgramBatch(double const * inputs, size_t n, double * outputs) {
+        for (size_t i {0}; i < n; ++i) {
+            ResetRegisters();
+            Input(inputs[i]);
+            outputs[i] = ExecuteProgram();
+        }
+    }
+
+    // Same results as ExecuteProgramBatch(), for evaluators that re-run the same inputs every
+    // generation: programs that can reuse a parent's work (see LinearProgram) keep up to
+    // 'snapshot_bytes' of intermediate state for that
+    virtual void ExecuteProgramBatchIncremental(double const * inputs, size_t n, double * outputs,
+        size_t snapshot_bytes) {
+        (void) snapshot_bytes;
+        ExecuteProgramBatch(inputs, n, outputs);
+    }
+
+    // ExecuteProgramBatch() for every program in 'group' (which this one is usually part of):
+    // program g's outputs go in outputs[g * n, (g + 1) * n). Programs that can share work
+    // between similar programs (see LinearProgram) override this
+    virtual SharedBatchStats ExecuteGroupBatch(std::span<Program * const> group, double const * inputs,
+        size_t n, double * outputs) const {
+        for (size_t g {0}; g < group.size(); ++g) group[g]->ExecuteProgramBatch(inputs, n, outputs + g * n);
+        return {};
+    }
+
+    void ExecuteProgramBatch(emp::vector<double> const & inputs, emp::vector<double> & outputs) {
+        outputs.resize(inputs.size());
+        ExecuteProgramBatch(inputs.data(), inputs.size(), outputs.data());
+    }
+
     virtual void Input(double x) = 0;
     // virtual void Input(emp::vector<double> x) = 0;
 
@@ -44,9 +111,21 @@ public:
 
     virtual emp::vector<Instruction> GetInstructions() const = 0;
     virtual void SetInstructions(emp::vector<Instruction> const & instr) = 0;
+    // Views of the instructions, without the copies GetInstructions()/SetInstructions() make
+    // Writes through EditInstructions() must be followed by CommitInstructions(), which validates
+    // them and updates everything derived from them (see Variator::ApplyInPlace())
+    virtual std::span<Instruction const> ViewInstructions() const = 0;
+    virtual std::span<Instruction> EditInstructions() = 0;
+    virtual void CommitInstructions() = 0;
+    // Whether instruction i can affect the output (false past the end of the program)
+    virtual bool IsEffectiveInstruction(size_t i) const = 0;
 
     virtual void PrintProgram(std::ostream & os) const = 0;
 
+    // Programs that compute the same thing (up to introns and register numbering) hash the same,
+    // so an evaluator that only looks at the program's outputs gives them the same fitness
+    virtual std::uint64_t CanonicalHash() const = 0;
+
     friend std::ostream & operator<<(std::ostream & os, Program const & prog) {
         prog.PrintProgram(os);
         return os;
@@ -54,4 +133,4 @@ public:
     
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -1,12 +1,32 @@
 #ifndef BASE_SELECT_HPP
 #define BASE_SELECT_HPP
 
+#include <span>
 #include <memory>
+#include <utility>
+
+#include "emp/base/vector.hpp"
+
+// What selection gets to see of a population, one column per value, indexed like the population
+// Kept by the estimator alongside its programs, so selection is a scan over plain arrays instead
+// of a virtual call through a pointer for every entrant
+struct PopulationColumns {
+    emp::vector<double> fitness;
+    emp::vector<double> second_fitness; // empty without a secondary evaluator
+    emp::vector<std::pair<double, double>> behavior; // empty for non-maze programs
+
+    size_t Size() const { return fitness.size(); }
+};
 
 class Selector {
 public:
     virtual ~Selector() = default;
-    virtual Program const & Select(std::vector<std::unique_ptr<Program>> const & pop) const = 0;
+    // Index of the selected individual
+    virtual size_t Select(PopulationColumns const & pop) const = 0;
+    // Fills 'out' with as many selections, drawn in order (same as calling Select() for each)
+    virtual void SelectBatch(PopulationColumns const & pop, std::span<size_t> out) const {
+        for (size_t & i : out) i = Select(pop);
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,9 @@
 #define BASE_VARI_HPP
 
 #include <memory>
+#include <span>
+#include <algorithm>
+#include <stdexcept>
 
 enum class VariatorType {
     BINARY, // crossover
@@ -17,6 +20,53 @@ public:
     // For crossover, returns a new child from two parents
     virtual std::unique_ptr<Program> Apply(Program const &, Program const &) const = 0;
 
+    // Same as Apply(), but also adds to 'changed' the indices of the instructions where the child
+    // may differ from 'prog' (for crossover, from the first parent). Extra indices are fine,
+    // missing ones are not. By default, the child's instructions are compared with the parent's.
+    virtual std::unique_ptr<Program> ApplyTracked(Program const & prog, emp::vector<size_t> & changed) const {
+        std::unique_ptr<Program> child {Apply(prog)};
+        DiffInstructions(prog, *child, changed);
+        return child;
+    }
+    virtual std::unique_ptr<Program> ApplyTracked(Program const & p1, Program const & p2,
+        emp::vector<size_t> & changed) const {
+        std::unique_ptr<Program> child {Apply(p1, p2)};
+        DiffInstructions(p1, *child, changed);
+        return child;
+    }
+
+    // In-place versions, which write the child straight into existing storage (see
+    // Estimator::Evolve()): 'child' holds a copy of the first parent (see Program::Assign()), or
+    // whatever the variators before this one made of it, and is changed where it stands.
+    // Crossover also reads 'other', the second parent. Indices go into 'changed' as with
+    // ApplyTracked(), and the child is left with no fitness and reset registers.
+    // By default these go through ApplyTracked(), which allocates; the variators in variate/
+    // override them with a single pass over the instructions (see Program::EditInstructions())
+    virtual void ApplyInPlace(Program & child, emp::vector<size_t> & changed) const {
+        std::unique_ptr<Program> made {ApplyTracked(child, changed)};
+        child.Assign(*made);
+    }
+    virtual void ApplyInPlace(Program & child, Program const & other, emp::vector<size_t> & changed) const {
+        std::unique_ptr<Program> made {ApplyTracked(child, other, changed)};
+        child.Assign(*made);
+    }
+
+    // Crossover that makes two children in one pass: 'child' (a copy of the first parent) as
+    // above, and 'sibling' (a copy of the second parent) with the opposite choices, with its
+    // changes tracked against the second parent in 'sibling_changed'
+    // Only for variators where MakesSiblings() is true
+    virtual bool MakesSiblings() const { return false; }
+    virtual void ApplyInPlace(Program &, Program &, emp::vector<size_t> &, emp::vector<size_t> &) const {
+        throw std::logic_error("This variator doesn't make siblings.");
+    }
+
+    static void DiffInstructions(Program const & a, Program const & b, emp::vector<size_t> & changed) {
+        std::span<Instruction const> const instr_a {a.ViewInstructions()};
+        std::span<Instruction const> const instr_b {b.ViewInstructions()};
+        for (size_t i {0}; i < std::max(instr_a.size(), instr_b.size()); ++i) {
+            if (i >= instr_a.size() || i >= instr_b.size() || !(instr_a[i] == instr_b[i])) changed.push_back(i);
+        }
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,106 @@
+#ifndef BATCH_EXEC_HPP
+#define BATCH_EXEC_HPP
+
+// Runs instructions over many fitness cases at once.
+// The register file is laid out as [register][case]: row r holds register r for every case,
+// so each instruction becomes a plain loop over contiguous values that the compiler can
+// turn into SSE/AVX code. Everything inside the loops is branch-free (selects, no ifs).
+// Templated on the register type (see numeric.hpp); float doubles the number of cases per vector.
+
+#include <cstddef>
+#include <algorithm>
+
+#include "instructions.hpp"
+#include "numeric.hpp"
+
+// r[i] = op (r[j] r[k]) (or op (r[j] r[t] r[k]) if ternary) for all 'n' cases,
+// clamped like the scalar interpreters
+// 'scratch' must hold 'n' values; it is used to broadcast a constant r[k]
+template <typename T>
+void ExecuteInstructionBatch(Instruction const & instr, T * regs, size_t n, T * scratch) {
+    using N = NumericTraits<T>;
+    T const * a {regs + instr.Rj * n};
+    T const * b;
+    if (instr.Rk_type == RkType::CONSTANT) {
+        std::fill(scratch, scratch + n, N::FromDouble(GLOBAL_CONSTANTS.GetConstant(instr.Rk)));
+        b = scratch;
+    }
+    else {
+        b = regs + instr.Rk * n;
+    }
+    T * out {regs + instr.Ri * n};
+
+    if (instr.op_type == 1) { // TERNARY
+        T const * t {regs + instr.Rt * n};
+        if (GLOBAL_OPERATORS.GetTernaryOpCode(instr.op) == OpCode::IF3) {
+            for (size_t c {0}; c < n; ++c) out[c] = N::Clamp(N::AsBool(a[c]) ? t[c] : b[c]);
+        }
+        else {
+            for (size_t c {0}; c < n; ++c) {
+                out[c] = N::Clamp(GLOBAL_OPERATORS.ApplyTernary(instr.op, a[c], t[c], b[c]));
+            }
+        }
+        return;
+    }
+
+    switch (GLOBAL_OPERATORS.GetOpCode(instr.op)) {
+        case OpCode::ADD:
+            for (size_t c {0}; c < n; ++c) out[c] = N::Clamp(N::Add(a[c], b[c]));
+            break;
+        case OpCode::SUB:
+            for (size_t c {0}; c < n; ++c) out[c] = N::Clamp(N::Sub(a[c], b[c]));
+            break;
+        case OpCode::MULT:
+            for (size_t c {0}; c < n; ++c) out[c] = N::Clamp(N::Mult(a[c], b[c]));
+            break;
+        case OpCode::DIV:
+            if constexpr (std::is_floating_point_v<T>) {
+                // protected: divide by 1 where b == 0, then select 1, so the loop has no branch
+                for (size_t c {0}; c < n; ++c) {
+                    T q {a[c] / ((b[c] != 0) ? b[c] : T{1})};
+                    out[c] = N::Clamp((b[c] != 0) ? q : T{1});
+                }
+            }
+            else {
+                for (size_t c {0}; c < n; ++c) out[c] = N::Clamp(N::Div(a[c], b[c]));
+            }
+            break;
+        case OpCode::AND:
+            for (size_t c {0}; c < n; ++c) out[c] = N::FromBool(N::AsBool(a[c]) & N::AsBool(b[c]));
+            break;
+        case OpCode::OR:
+            for (size_t c {0}; c < n; ++c) out[c] = N::FromBool(N::AsBool(a[c]) | N::AsBool(b[c]));
+            break;
+        case OpCode::NAND:
+            for (size_t c {0}; c < n; ++c) out[c] = N::FromBool(!(N::AsBool(a[c]) & N::AsBool(b[c])));
+            break;
+        case OpCode::NOR:
+            for (size_t c {0}; c < n; ++c) out[c] = N::FromBool(!(N::AsBool(a[c]) | N::AsBool(b[c])));
+            break;
+        case OpCode::XOR:
+            for (size_t c {0}; c < n; ++c) out[c] = N::FromBool(N::AsBool(a[c]) != N::AsBool(b[c]));
+            break;
+        case OpCode::GREATER:
+            for (size_t c {0}; c < n; ++c) out[c] = N::FromBool(N::AsBool(a[c]) > N::AsBool(b[c]));
+            break;
+        case OpCode::EQUAL:
+            for (size_t c {0}; c < n; ++c) out[c] = N::FromBool(N::AsBool(a[c]) == N::AsBool(b[c]));
+            break;
+        case OpCode::LESS:
+            for (size_t c {0}; c < n; ++c) out[c] = N::FromBool(N::AsBool(a[c]) < N::AsBool(b[c]));
+            break;
+        case OpCode::IF:
+            for (size_t c {0}; c < n; ++c) out[c] = N::Clamp(N::AsBool(a[c]) ? b[c] : N::Zero());
+            break;
+        case OpCode::NOT:
+            for (size_t c {0}; c < n; ++c) out[c] = N::FromBool(!N::AsBool(a[c]));
+            break;
+        default: // user-registered operator, no way around calling it per case
+            for (size_t c {0}; c < n; ++c) {
+                out[c] = N::Clamp(GLOBAL_OPERATORS.Apply(instr.op, a[c], b[c]));
+            }
+            break;
+    }
+}
+
+#endif
@@ -4,6 +4,11 @@
 #include <iostream>
 #include <vector>
 #include <random>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+
+#include "random.hpp"
 
 class Constants {
 private:
@@ -32,6 +37,8 @@ public:
     // }
 
     void RegisterConstant(double num) {
+        // Instructions refer to constants with a 16-bit index
+        if (constants.size() > UINT16_MAX) throw std::runtime_error("Constant pool is full.");
         constants.push_back(num);
     }
 
@@ -78,9 +85,31 @@ public:
     double GetRandomConstant() const {
         if (constants.empty()) throw std::runtime_error("No constants available.");
         std::uniform_int_distribution<size_t> dist(0, constants.size() - 1);
-        return constants[dist(rng)];
+        return constants[dist(ReplicateStream::Or(rng))];
+    }
+
+    // Instructions store an index into this set instead of the constant itself
+    size_t GetRandomConstantID() const {
+        if (constants.empty()) throw std::runtime_error("No constants available.");
+        std::uniform_int_distribution<size_t> dist(0, constants.size() - 1);
+        return dist(ReplicateStream::Or(rng));
+    }
+
+    double GetConstant(size_t id) const {
+        assert(id < constants.size() && "Invalid constant ID.");
+        return constants[id];
+    }
+
+    // Returns the index of 'num', registering it first if it isn't in the set yet
+    // (e.g., constants read from a saved program)
+    size_t GetConstantID(double num) {
+        for (size_t i {0}; i < constants.size(); ++i) {
+            if (constants[i] == num) return i;
+        }
+        RegisterConstant(num);
+        return constants.size() - 1;
     }
 
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -32,10 +32,12 @@ Operators GLOBAL_OPERATORS;
 #include "arith_prog.hpp"
 
 #include "../evaluate/mse_eval.hpp"
+#include "../evaluate/bool_eval.hpp"
 
 #include "../variate/simple_mutate.hpp"
 #include "../variate/simple_xover.hpp"
 #include "../variate/rand_variator.hpp"
+#include "../variate/effective_mutate.hpp"
 
 #include "../select/tour_select.hpp"
 
@@ -44,4 +46,4 @@ Operators GLOBAL_OPERATORS;
 
 #include "estimator.hpp"
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
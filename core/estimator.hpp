@@ -7,11 +7,56 @@
 #include <iomanip>
 #include <fstream>
 #include <cassert>
+#include <tuple>
+#include <span>
+#include <numeric>
+#include <mutex>
+#include <typeinfo>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
 
 #include "emp/base/vector.hpp"
 
-class Estimator {
+#include "fitness_cache.hpp"
+#include "thread_pool.hpp"
+#include "random.hpp"
+#include "alloc_counter.hpp"
+
+// ProgramT, EvaluatorT, SelectorT and the variators are the concrete classes used, so calls into
+// them in the generation loop are resolved at compile time (the classes are final) and maze
+// programs/evaluators are recognized without RTTI. ProgramT must be the prototype's exact type.
+// With no variator types, variators are a runtime list instead. 'Estimator' (below) is the
+// type-erased version, which works with any mix of components.
+template <typename ProgramT, typename EvaluatorT, typename SelectorT, typename... VariatorTs>
+class BasicEstimator {
+    static_assert(std::is_base_of_v<Program, ProgramT>);
+    static_assert(std::is_base_of_v<Evaluator, EvaluatorT>);
+    static_assert(std::is_base_of_v<Selector, SelectorT>);
+    static_assert((std::is_base_of_v<Variator, VariatorTs> && ...));
+
+public:
+    using VariatorList = std::conditional_t<sizeof...(VariatorTs) == 0,
+        emp::vector<std::unique_ptr<Variator>>, std::tuple<VariatorTs...>>;
+
 private:
+    static constexpr bool type_erased {std::is_same_v<ProgramT, Program>};
+    static constexpr bool static_maze_program {std::is_base_of_v<MazeProgramBase, ProgramT>};
+    static constexpr bool static_maze_eval {std::is_base_of_v<MazeEvaluator, EvaluatorT>};
+
+    // Population members are ProgramT (checked once, on the prototype)
+    static ProgramT & As(Program & p) { return static_cast<ProgramT &>(p); }
+    static ProgramT const & As(Program const & p) { return static_cast<ProgramT const &>(p); }
+
+    static MazeProgramBase * AsMaze(Program & p) {
+        if constexpr (static_maze_program) return &As(p);
+        else if constexpr (type_erased) return dynamic_cast<MazeProgramBase *>(&p);
+        else return nullptr;
+    }
+    static MazeProgramBase const * AsMaze(Program const & p) {
+        return AsMaze(const_cast<Program &>(p));
+    }
+
     size_t pop_size {POP_SIZE};
     size_t gens {GENS};
     size_t elitism_count {ELITISM_COUNT};
@@ -19,12 +64,29 @@ private:
     Operators operators;
     Constants constants;
 
-    std::unique_ptr<Evaluator> evaluator;
-    emp::vector<std::unique_ptr<Variator>> variators;
-    std::unique_ptr<Selector> selector;
+    // Components are shared with the replicates of ParallelMultiRunEvolve(), which only read them
+    std::shared_ptr<EvaluatorT> evaluator;
+    std::shared_ptr<VariatorList const> variators;
+    std::shared_ptr<SelectorT> selector;
 
     emp::vector<std::unique_ptr<Program>> population;
-    std::unique_ptr<Program> prototype; // to grab the right Program subclass
+    // Second buffer of pop_size programs, allocated once: each generation is written into it, then
+    // the two are swapped. Programs are overwritten in place (see Program::Assign())
+    emp::vector<std::unique_ptr<Program>> next_population;
+    emp::vector<bool> next_inherited;
+    emp::vector<size_t> elite_order; // population indices, best first (up to elitism_count)
+    emp::vector<size_t> changed, sibling_changed; // reused for every child
+    emp::vector<size_t> parents; // the generation's selections, two per mating
+    // Evaluation bookkeeping, also reused every generation (see EvalPopulation())
+    emp::vector<size_t> pending, miss_idx, dup_idx, hash_order, first_with_hash;
+    emp::vector<std::uint64_t> hashes;
+    emp::vector<double> fitnesses;
+    emp::vector<std::unique_ptr<Program>> subset;
+    emp::vector<double> median_buffer;
+    // Heap allocations made by each whole generation (selection, variation, evaluation and
+    // statistics), only recorded when allocations are counted (see AllocationCounter)
+    emp::vector<size_t> allocation_history;
+    std::shared_ptr<ProgramT> prototype; // to grab the right Program subclass
 
     std::unique_ptr<Program> best_program;
     emp::vector<double> best_fitness_history;
@@ -39,8 +101,9 @@ private:
     emp::vector<double> semantic_intron_elim_history;
     emp::vector<double> structural_intron_history;
 
-    // Behaviors collected from the population (changes every generation)
-    emp::vector<std::pair<double, double>> pop_behavior_set;
+    // Fitness, second fitness and behavior of population[i] at index i, for selection and the
+    // statistics (refreshed whenever the population is evaluated)
+    PopulationColumns columns;
     // Behaviors collected across all generations, all runs
     emp::vector<std::pair<double, double>> all_behaviors; 
 
@@ -59,74 +122,328 @@ private:
     emp::vector<double> second_median_fitness_history;
     emp::vector<double> p_min_history; // novelty threshold for archive
     
-    std::unique_ptr<Evaluator> second_evaluator;
+    std::shared_ptr<Evaluator> second_evaluator;
 
     // ------------------------
 
+    // Fitnesses and behaviors from the (primary) evaluator, by program hash
+    // Kept across runs (see MultiRunEvolve()), since the evaluator and its training set don't change
+    FitnessCache cache;
+    bool use_cache {false};
+
+    // inherited[i]: population[i] computes exactly what its parent does (see IsNeutralChild()),
+    // and already carries the parent's fitness, second fitness and behavior
+    emp::vector<bool> inherited;
+    emp::vector<size_t> neutral_history; // neutral children per generation
+
+    // Evaluates individuals concurrently when set (see SetThreadCount())
+    std::unique_ptr<ThreadPool> pool;
+    // Set on the replicates of ParallelMultiRunEvolve(): other threads use the evaluator too, so
+    // it only gets per-program calls (see EvaluateSubset())
+    bool replicate {false};
+
     std::mt19937 rng;
 
     bool verbose;
     std::ostream & os;
 
 public:
-    Estimator(std::unique_ptr<Evaluator> eval, 
-        emp::vector<std::unique_ptr<Variator>> vars,
-        std::unique_ptr<Selector> sel,
-        std::unique_ptr<Program> prot,
+    BasicEstimator(std::unique_ptr<EvaluatorT> eval, 
+        VariatorList vars,
+        std::unique_ptr<SelectorT> sel,
+        std::unique_ptr<ProgramT> prot,
         std::unique_ptr<Evaluator> s_eval = nullptr,
         bool verbose=false,
         std::ostream & os=std::cout)
       : operators(GLOBAL_OPERATORS),
         constants(GLOBAL_CONSTANTS),
         evaluator(std::move(eval)), 
-        variators(std::move(vars)),
+        variators(std::make_shared<VariatorList const>(std::move(vars))),
         selector(std::move(sel)),
         prototype(std::move(prot)),
         second_evaluator(std::move(s_eval)),
         rng(SEED),
         verbose(verbose),
-        os(os) {}
+        os(os) {
+        if (!type_erased && typeid(*prototype) != typeid(ProgramT)) {
+            throw std::runtime_error("The prototype must be exactly of the estimator's program type.");
+        }
+    }
+
+private:
+    // Replicate for ParallelMultiRunEvolve(): same components and settings, run state of its own
+    BasicEstimator(BasicEstimator const & parent, std::ostream & os)
+      : pop_size(parent.pop_size),
+        gens(parent.gens),
+        elitism_count(parent.elitism_count),
+        operators(parent.operators),
+        constants(parent.constants),
+        evaluator(parent.evaluator),
+        variators(parent.variators),
+        selector(parent.selector),
+        prototype(parent.prototype),
+        p_min(parent.p_min),
+        second_evaluator(parent.second_evaluator),
+        cache(parent.cache),
+        use_cache(parent.use_cache),
+        replicate(true),
+        rng(SEED),
+        verbose(false),
+        os(os) { }
+
+public:
     
     Program const & GetBestProgram() const { return *best_program; }
 
+    // max_entries = 0 means unbounded
+    // Has no effect with evaluators that aren't cacheable (see Evaluator::IsCacheable())
+    void EnableFitnessCache(size_t max_entries=0) {
+        use_cache = true;
+        cache.SetMaxEntries(max_entries);
+    }
+    void DisableFitnessCache() { use_cache = false; }
+    // Needed if the evaluator's training set is changed from outside
+    void ClearFitnessCache() { cache.Clear(); }
+    FitnessCache const & GetFitnessCache() const { return cache; }
+    emp::vector<size_t> const & GetNeutralHistory() const { return neutral_history; }
+    // Empty unless built with -DKARLGP_COUNT_ALLOCATIONS; counts allocations on every thread
+    emp::vector<size_t> const & GetAllocationHistory() const { return allocation_history; }
+
+    // Evaluations (fitness, secondary fitness and behavior) run on 'threads' threads, the calling
+    // one included; 0 means one per hardware thread, 1 turns it off
+    // Each individual is evaluated on its own by a single thread, through Evaluator::Evaluate(),
+    // so evaluators must be safe to call concurrently on different programs. Results are the same
+    // as with one thread, except that population-level evaluation modes (e.g., MSE's semantic
+    // dedup) are skipped. Cache lookups and stores stay on the calling thread.
+    void SetThreadCount(size_t threads) {
+        pool.reset();
+        if (threads != 1) pool = std::make_unique<ThreadPool>(threads);
+        if (pool && pool->Size() == 1) pool.reset();
+    }
+    size_t GetThreadCount() const { return pool ? pool->Size() : 1; }
+
+    // The child has its parent's phenotype if every instruction that changed is a structural
+    // intron of both: effectiveness only ever flows through effective instructions, so the
+    // rest of the two programs has the same effective instructions
+    static bool IsNeutralChild(Program const & parent, Program const & child, emp::vector<size_t> const & changed) {
+        for (size_t i : changed) {
+            if (parent.IsEffectiveInstruction(i) || child.IsEffectiveInstruction(i)) return false;
+        }
+        return true;
+    }
+
+    // Copies over everything evaluation would have given the child
+    static void InheritEvaluation(Program const & parent, Program & child) {
+        As(child).SetFitness(As(parent).GetFitness());
+        if (As(parent).IsSecondEvaluated()) As(child).SetSecondFitness(As(parent).GetSecondFitness());
+        MazeProgramBase const * maze_parent {AsMaze(parent)};
+        if (maze_parent && maze_parent->IsBehaviorEvaluated()) AsMaze(child)->SetBehavior(maze_parent->GetBehavior());
+    }
+
+    bool IsInherited(size_t i) const { return i < inherited.size() && inherited[i]; }
+
+    // Runs the evaluator on population[i] for each i in 'indices' (all at once, see
+    // EvalPopulation()) and puts the results in 'fitnesses'; the programs are moved out for that
+    // and put back afterwards
+    // With threads, or in a replicate, every program is evaluated on its own instead (see SetThreadCount())
+    void EvaluateSubset(emp::vector<size_t> const & indices) {
+        if (pool || replicate) {
+            fitnesses.resize(indices.size());
+            auto eval_one = [&](size_t s) { fitnesses[s] = evaluator->Evaluate(*population[indices[s]]); };
+            if (pool) pool->ParallelFor(indices.size(), eval_one);
+            else for (size_t s {0}; s < indices.size(); ++s) eval_one(s);
+            return;
+        }
+        if (indices.size() == population.size()) {
+            evaluator->EvaluatePopulation(population, fitnesses);
+            return;
+        }
+        subset.clear();
+        for (size_t i : indices) subset.push_back(std::move(population[i]));
+        evaluator->EvaluatePopulation(subset, fitnesses);
+        for (size_t s {0}; s < indices.size(); ++s) population[indices[s]] = std::move(subset[s]);
+    }
+
+    // For each i in 'indices' (in increasing order), first_with_hash[i] is the first index in
+    // 'indices' whose hash matches hashes[i] (i itself if there is none before it)
+    // Sorts rather than filling a hash map, so it doesn't allocate once the buffers are big enough
+    void GroupByHash(emp::vector<size_t> const & indices) {
+        hash_order.assign(indices.begin(), indices.end());
+        std::sort(hash_order.begin(), hash_order.end(), [&](size_t a, size_t b) {
+            return hashes[a] < hashes[b] || (hashes[a] == hashes[b] && a < b);
+        });
+        first_with_hash.resize(population.size());
+        for (size_t k {0}; k < hash_order.size(); ++k) {
+            size_t const i {hash_order[k]};
+            bool const repeat {k > 0 && hashes[hash_order[k - 1]] == hashes[i]};
+            first_with_hash[i] = repeat ? first_with_hash[hash_order[k - 1]] : i;
+        }
+    }
+
     void InitPopulation() {
         for (size_t i {0}; i < pop_size; ++i) {
             std::unique_ptr<Program> prog {prototype->New()};
             population.emplace_back(std::move(prog));
         }
+        // Clone(), unlike New(), doesn't draw random numbers, so this doesn't change the run
+        next_population.clear();
+        for (size_t i {0}; i < pop_size; ++i) next_population.emplace_back(prototype->Clone());
+    }
+
+    // Whether a crossover makes children in pairs (see Variator::MakesSiblings())
+    bool MakesSiblings() const {
+        if constexpr (sizeof...(VariatorTs) == 0) {
+            return std::any_of(variators->begin(), variators->end(),
+                [](std::unique_ptr<Variator> const & v) { return v->MakesSiblings(); });
+        }
+        else return std::apply([](auto const & ... vs) { return (vs.MakesSiblings() || ...); }, *variators);
+    }
+
+    // Index of the highest value (the first one on ties)
+    static size_t BestIndex(emp::vector<double> const & column) {
+        assert(!column.empty());
+        return std::max_element(column.begin(), column.end()) - column.begin();
+    }
+
+    // Room for every generation of the run, so recording one doesn't allocate
+    // Must be called after the first UpdatePopulationBehaviorSet() (behaviors are only kept for maze runs)
+    void ReserveHistories() {
+        for (emp::vector<double> * h : {&best_fitness_history, &avg_fitness_history, &median_fitness_history,
+            &second_best_fitness_history, &second_avg_fitness_history, &second_median_fitness_history, &p_min_history}) {
+            h->reserve(h->size() + gens + 1);
+        }
+        neutral_history.reserve(neutral_history.size() + gens);
+        if (AllocationCounter::enabled) allocation_history.reserve(allocation_history.size() + gens);
+        all_behaviors.reserve(all_behaviors.size() + (gens + 1) * columns.behavior.size());
     }
 
+    // Copies 'src' into 'dst', reusing dst's storage once it exists
+    static void KeepCopy(std::unique_ptr<Program> & dst, Program const & src) {
+        if (dst) dst->Assign(src);
+        else dst = src.Clone();
+    }
+
+    // The evaluator sees the whole population at once, so it can block the work
+    // (see MSE::SetBlocking())
+    // Children that inherited their parent's fitness are skipped, unless fitness depends on more
+    // than the program (see Evaluator::IsCacheable())
     void EvalPopulation() {
-        for (std::unique_ptr<Program> & p : population) {
-            p->SetFitness(evaluator->Evaluate(*p));
+        EvalPopulationFitness();
+        columns.fitness.resize(population.size());
+        for (size_t i {0}; i < population.size(); ++i) columns.fitness[i] = As(*population[i]).GetFitness();
+    }
+
+    void EvalPopulationFitness() {
+        pending.clear();
+        for (size_t i {0}; i < population.size(); ++i) {
+            if (!IsInherited(i) || !evaluator->IsCacheable()) pending.push_back(i);
         }
+
+        if (!use_cache || !evaluator->IsCacheable()) {
+            EvaluateSubset(pending);
+            for (size_t p {0}; p < pending.size(); ++p) {
+                As(*population[pending[p]]).SetFitness(fitnesses[p]);
+            }
+            return;
+        }
+
+        // Only programs whose hash is in neither the cache nor earlier in the population are
+        // evaluated; later ones with the same hash copy the first one's fitness
+        hashes.resize(population.size());
+        for (size_t i : pending) hashes[i] = As(*population[i]).CanonicalHash();
+        GroupByHash(pending);
+        miss_idx.clear();
+        dup_idx.clear();
+        for (size_t i : pending) {
+            if (first_with_hash[i] != i) {
+                dup_idx.push_back(i);
+                cache.CountHit();
+            }
+            else if (std::optional<double> f {cache.FindFitness(hashes[i])}) As(*population[i]).SetFitness(*f);
+            else miss_idx.push_back(i);
+        }
+
+        EvaluateSubset(miss_idx);
+        for (size_t m {0}; m < miss_idx.size(); ++m) {
+            As(*population[miss_idx[m]]).SetFitness(fitnesses[m]);
+            cache.StoreFitness(hashes[miss_idx[m]], fitnesses[m]);
+        }
+
+        // Duplicates of programs looked up or evaluated just now
+        for (size_t i : dup_idx) As(*population[i]).SetFitness(As(*population[first_with_hash[i]]).GetFitness());
     }
 
     // Secondary fitness; has no effect on selection
     void EvalPopulationSecondary() {
         assert(second_evaluator && "No secondary evaluator has been set.");
-        for (std::unique_ptr<Program> & p : population) {
-            p->SetSecondFitness(second_evaluator->Evaluate(*p));
-        }
+        auto eval_one = [&](size_t i) {
+            if (IsInherited(i) && second_evaluator->IsCacheable() && As(*population[i]).IsSecondEvaluated()) return;
+            As(*population[i]).SetSecondFitness(second_evaluator->Evaluate(*population[i]));
+        };
+        if (pool) pool->ParallelFor(population.size(), eval_one);
+        else for (size_t i {0}; i < population.size(); ++i) eval_one(i);
+        columns.second_fitness.resize(population.size());
+        for (size_t i {0}; i < population.size(); ++i) columns.second_fitness[i] = As(*population[i]).GetSecondFitness();
+    }
+
+    MazeEvaluator & BehaviorEvaluator() {
+        if constexpr (static_maze_eval) return *evaluator;
+        else return dynamic_cast<MazeEvaluator&>(*evaluator);
     }
 
     // Evaluates BEHAVIOR of each program in the population
-    // Appends them to the population behavior set
+    // Fills the behavior column
     // Must be called BEFORE EvalPopulation() (which calculates NOVELTY)
+    // Nothing to do for (statically known) non-maze programs or evaluators
     void UpdatePopulationBehaviorSet() {
-        pop_behavior_set.clear();
-        
-        // MazeNoveltyEvaluator & eval {dynamic_cast<MazeNoveltyEvaluator&>(*evaluator)};
-        MazeEvaluator & eval {dynamic_cast<MazeEvaluator&>(*evaluator)};
+        columns.behavior.clear();
+        if constexpr (type_erased || (static_maze_program && static_maze_eval)) {
+            // MazeNoveltyEvaluator & eval {dynamic_cast<MazeNoveltyEvaluator&>(*evaluator)};
+            MazeEvaluator & eval {BehaviorEvaluator()};
+
+            bool const cached {use_cache && eval.IsCacheable()};
+            // Simulations are collected first, so they can run concurrently; with the cache, a
+            // program with the same hash as an earlier one in the population just copies its behavior
+            pending.clear();
+            for (size_t i {0}; i < population.size(); ++i) {
+                MazeProgramBase * maze_prog {AsMaze(*population[i])};
+                if (!maze_prog) throw std::bad_cast();
+                if (IsInherited(i) && maze_prog->IsBehaviorEvaluated()) continue;
+                pending.push_back(i);
+            }
 
-        for (std::unique_ptr<Program> & p : population) {
-            MazeProgram & prog {dynamic_cast<MazeProgram&>(*p)};
+            miss_idx.clear();
+            dup_idx.clear();
+            if (!cached) miss_idx.assign(pending.begin(), pending.end());
+            else {
+                hashes.resize(population.size());
+                for (size_t i : pending) hashes[i] = AsMaze(*population[i])->CanonicalHash();
+                GroupByHash(pending);
+                for (size_t i : pending) {
+                    if (first_with_hash[i] != i) {
+                        dup_idx.push_back(i);
+                        cache.CountHit();
+                    }
+                    else if (auto b {cache.FindBehavior(hashes[i])}) AsMaze(*population[i])->SetBehavior(*b);
+                    else miss_idx.push_back(i);
+                }
+            }
 
-            prog.SetBehavior(eval.EvaluateBehavior(prog));
-            pop_behavior_set.emplace_back(prog.GetBehavior());
+            auto simulate = [&](size_t m) {
+                MazeProgramBase & prog {*AsMaze(*population[miss_idx[m]])};
+                prog.SetBehavior(eval.EvaluateBehavior(prog));
+            };
+            if (pool) pool->ParallelFor(miss_idx.size(), simulate);
+            else for (size_t m {0}; m < miss_idx.size(); ++m) simulate(m);
+
+            if (cached) {
+                for (size_t i : miss_idx) cache.StoreBehavior(hashes[i], AsMaze(*population[i])->GetBehavior());
+            }
+            for (size_t i : dup_idx) AsMaze(*population[i])->SetBehavior(AsMaze(*population[first_with_hash[i]])->GetBehavior());
+            for (std::unique_ptr<Program> const & prog : population) columns.behavior.emplace_back(AsMaze(*prog)->GetBehavior());
         }
 
-        // for (auto & b : pop_behavior_set) {
+        // for (auto & b : columns.behavior) {
         //     std::cout << "DEBUG Behavior: (" << b.first << ", " << b.second << ")\n";
         // }
     }
@@ -140,9 +457,9 @@ public:
     // Must be called AFTER EvalPopulation()
     size_t UpdateArchive() {
         size_t addition_count {0};
-        for (std::unique_ptr<Program> & p : population) {
-            if (p->GetFitness() > p_min) { // we're maximizing
-                archive.emplace_back(p->Clone());
+        for (size_t i {0}; i < population.size(); ++i) {
+            if (columns.fitness[i] > p_min) { // we're maximizing
+                archive.emplace_back(As(*population[i]).Clone());
                 ++addition_count;
             }
         }
@@ -182,28 +499,25 @@ public:
 
     double AvgFitness() {
         double total {0};
-        for (std::unique_ptr<Program> const & p : population) {
-            total += p->GetFitness();
+        for (double f : columns.fitness) {
+            total += f;
         }
-        return total / population.size();
+        return total / columns.fitness.size();
     }
 
     double AvgSecondFitness() {
         assert(second_evaluator && "No secondary evaluator has been set.");
+        assert(columns.second_fitness.size() == population.size() && "Secondary fitness has not been evaluated.");
         double total {0};
-        for (std::unique_ptr<Program> const & p : population) {
-            total += p->GetSecondFitness();
+        for (double f : columns.second_fitness) {
+            total += f;
         }
-        return total / population.size();
+        return total / columns.second_fitness.size();
     }
 
     double MedianFitness() {
-        // emp::vector<std::unique_ptr<Program>> pop_ptr_copy;
-        emp::vector<double> fitnesses;
-        for (size_t i {0}; i < pop_size; ++i) {
-            // pop_ptr_copy.emplace_back(population[i]->Clone());
-            fitnesses.emplace_back(population[i]->GetFitness());
-        }
+        emp::vector<double> & fitnesses {median_buffer};
+        fitnesses.assign(columns.fitness.begin(), columns.fitness.end());
 
         std::sort(fitnesses.begin(), fitnesses.end());
 
@@ -220,11 +534,9 @@ public:
 
     double MedianSecondFitness() {
         assert(second_evaluator && "No secondary evaluator has been set.");
-        emp::vector<double> fitnesses;
-        for (size_t i {0}; i < pop_size; ++i) {
-            // pop_ptr_copy.emplace_back(population[i]->Clone());
-            fitnesses.emplace_back(population[i]->GetSecondFitness());
-        }
+        assert(columns.second_fitness.size() == population.size() && "Secondary fitness has not been evaluated.");
+        emp::vector<double> & fitnesses {median_buffer};
+        fitnesses.assign(columns.second_fitness.begin(), columns.second_fitness.end());
 
         std::sort(fitnesses.begin(), fitnesses.end());
 
@@ -241,6 +553,7 @@ public:
 
     void Reset() {
         population.clear();
+        columns = PopulationColumns{};
         best_program.reset();
         best_program2.reset();
 
@@ -256,6 +569,10 @@ public:
         archive.clear();
         p_min_history.clear();
 
+        inherited.clear();
+        neutral_history.clear();
+        allocation_history.clear();
+
         // quality_gain_history.clear();
         // success_rate_history.clear();
 
@@ -280,10 +597,11 @@ public:
         // // ------------------------
 
         UpdatePopulationBehaviorSet();
-        all_behaviors.insert(all_behaviors.end(), pop_behavior_set.begin(), pop_behavior_set.end());
+        ReserveHistories();
+        all_behaviors.insert(all_behaviors.end(), columns.behavior.begin(), columns.behavior.end());
 
         // // ---- NOVELTY SEARCH ----
-        // novelty_eval.SetOtherBehaviors(pop_behavior_set); // necessary before novelty evaluation
+        // novelty_eval.SetOtherBehaviors(columns.behavior); // necessary before novelty evaluation
         // // ------------------------
 
         EvalPopulation(); // evaluate their fitness (or novelty in the case of NS)
@@ -293,11 +611,7 @@ public:
         // UpdateArchive(); // archive updates always happen after EvalPopulation()
         // // ------------------------
 
-        auto best_it = std::max_element(population.begin(), population.end(),
-            [](std::unique_ptr<Program> const & a, std::unique_ptr<Program> const & b) {
-                return a->GetFitness() < b->GetFitness();
-            });
-        best_program = (*best_it)->Clone();
+        KeepCopy(best_program, *population[BestIndex(columns.fitness)]);
         best_fitness_history.emplace_back(best_program->GetFitness());
         avg_fitness_history.emplace_back(AvgFitness());
         median_fitness_history.emplace_back(MedianFitness());
@@ -305,11 +619,7 @@ public:
 
         // Secondary fitness metrics
         if (second_evaluator) {
-            auto best_it2 = std::max_element(population.begin(), population.end(),
-                [](std::unique_ptr<Program> const & a, std::unique_ptr<Program> const & b) {
-                    return a->GetSecondFitness() < b->GetSecondFitness();
-                });
-            best_program2 = (*best_it2)->Clone();
+            KeepCopy(best_program2, *population[BestIndex(columns.second_fitness)]);
             second_best_fitness_history.emplace_back(best_program2->GetSecondFitness());
             second_avg_fitness_history.emplace_back(AvgSecondFitness());
             second_median_fitness_history.emplace_back(MedianSecondFitness());
@@ -323,60 +633,113 @@ public:
         // Begin evolutionary loop
 
         size_t no_addition_counter {0};
+        bool const siblings {MakesSiblings()};
         for (size_t gen {0}; gen < gens; ++gen) {
+            size_t const generation_allocations {AllocationCounter::Count()};
             if (verbose) { 
                 PrintGenSummary(gen, best_fitness_history[gen], avg_fitness_history[gen], median_fitness_history[gen], os); 
             }
 
             if (verbose && gen % 10 == 0) {
                 os << "First 5 fitnesses: ";
-                for (int i {0}; i < 5; ++i) os << population[i]->GetFitness() << " ";
+                for (int i {0}; i < 5; ++i) os << columns.fitness[i] << " ";
                 os << "\n";
             }
 
-            emp::vector<std::unique_ptr<Program>> new_pop;
+            size_t filled {0}; // slots of next_population written so far
+            next_inherited.clear();
+            size_t neutral_count {0};
             // int success_count {0}; // For measuring success rate
 
             // ---- ELITISM ----
             if (elitism_count > 0) {
-                // Sort the population based on fitness (highest first)
-                emp::vector<std::unique_ptr<Program>> pop_copy;
-                for (auto & p : population) pop_copy.emplace_back(p->Clone());
-            
-                std::sort(pop_copy.begin(), pop_copy.end(),
-                    [](std::unique_ptr<Program> & a, std::unique_ptr<Program> & b) {
-                        return a->GetFitness() > b->GetFitness();
+                // Indices of the best programs first (highest fitness, ties go to the lower index)
+                size_t const elites {std::min({elitism_count, population.size(), pop_size})};
+                elite_order.resize(population.size());
+                std::iota(elite_order.begin(), elite_order.end(), size_t{0});
+                std::partial_sort(elite_order.begin(), elite_order.begin() + elites, elite_order.end(),
+                    [&](size_t a, size_t b) {
+                        double const fa {columns.fitness[a]};
+                        double const fb {columns.fitness[b]};
+                        return fa > fb || (fa == fb && a < b);
                     }
                 );
             
-                for (size_t i {0}; i < elitism_count && i < pop_copy.size(); ++i) {
-                    new_pop.emplace_back(std::move(pop_copy[i]));
+                for (; filled < elites; ++filled) {
+                    next_population[filled]->Assign(*population[elite_order[filled]]);
+                    next_inherited.push_back(true); // unchanged copies
                 }
             }
             // -----------------
             
 
             // Produce children - by default, we replace the entire population
-            while (new_pop.size() < pop_size) {
-                Program const & parent1 {selector->Select(population)};
-                Program const & parent2 {selector->Select(population)};
-
-                std::unique_ptr<Program> child {parent1.Clone()}; // Default: copy parent1
+            // Children are made where they stand, in their slots of the next buffer: each starts as
+            // a copy of its first parent and the variators change it in place. When a crossover
+            // makes siblings, children come in pairs, the second one starting from parent2
+            // Parents for the whole generation are selected up front, in one pass over the fitness column
+            size_t const matings {siblings ? (pop_size - filled + 1) / 2 : pop_size - filled};
+            parents.resize(2 * matings);
+            selector->SelectBatch(columns, std::span<size_t>(parents.data(), parents.size()));
+            for (size_t m {0}; filled < pop_size; ++m) {
+                Program const & parent1 {*population[parents[2 * m]]};
+                Program const & parent2 {*population[parents[2 * m + 1]]};
+
+                bool const pair {siblings && filled + 1 < pop_size};
+                Program & child {*next_population[filled]};
+                Program & sibling {*next_population[pair ? filled + 1 : filled]}; // same as child if !pair
+                child.Assign(parent1); // Default: copy parent1
+                changed.clear(); // instructions where child may differ from parent1
+                if (pair) {
+                    sibling.Assign(parent2);
+                    sibling_changed.clear();
+                }
+                bool varied {false};
 
                 // Not sure if this is a good way
                 // Be careful with ordering of variators in set
                 // If no binary variator exists, we just mutate child, which is a copy of parent1
 
                 // bool two_parents {false}; // For measuring success rate
-                for (std::unique_ptr<Variator> & variator: variators) {
-                    if (variator->Type() == VariatorType::BINARY) {
-                        child = variator->Apply(parent1, parent2);
+                auto apply = [&](auto const & variator) {
+                    if (variator.Type() == VariatorType::BINARY) {
+                        // starts over from the parents
+                        if (varied) {
+                            child.Assign(parent1);
+                            if (pair) sibling.Assign(parent2);
+                        }
+                        changed.clear();
+                        sibling_changed.clear();
+                        if (pair && variator.MakesSiblings()) variator.ApplyInPlace(child, sibling, changed, sibling_changed);
+                        else {
+                            variator.ApplyInPlace(child, parent2, changed);
+                            if (pair) variator.ApplyInPlace(sibling, parent1, sibling_changed);
+                        }
                         // two_parents = true;
                     }
-                    else if (variator->Type() == VariatorType::UNARY) {
-                        child = variator->Apply(*child);
+                    else if (variator.Type() == VariatorType::UNARY) {
+                        variator.ApplyInPlace(child, changed);
+                        if (pair) variator.ApplyInPlace(sibling, sibling_changed);
                     }
+                    varied = true;
+                };
+                if constexpr (sizeof...(VariatorTs) == 0) {
+                    for (std::unique_ptr<Variator> const & variator : *variators) apply(*variator);
                 }
+                else std::apply([&](auto const & ... vs) { (apply(vs), ...); }, *variators);
+
+                // Neutral variation: nothing to evaluate
+                auto settle = [&](Program & made, Program const & first, emp::vector<size_t> const & diff) {
+                    bool const neutral {IsNeutralChild(first, made, diff)};
+                    if (neutral) {
+                        InheritEvaluation(first, made);
+                        ++neutral_count;
+                    }
+                    next_inherited.push_back(neutral);
+                };
+                settle(child, parent1, changed);
+                if (pair) settle(sibling, parent2, sibling_changed);
+                filled += pair ? 2 : 1;
 
                 // Measuring success rate
                 // double parent1_fitness {parent1.GetFitness()};
@@ -394,15 +757,14 @@ public:
                 //     success = child_fitness < parent1_fitness;
                 // }
                 // if (success) ++success_count;
-
-
-                new_pop.emplace_back(std::move(child));
             }
 
-            // Update population
-            population = std::move(new_pop);
+            // Swap buffers: the old population is overwritten next generation
+            std::swap(population, next_population);
+            std::swap(inherited, next_inherited);
+            neutral_history.emplace_back(neutral_count);
             UpdatePopulationBehaviorSet();
-            all_behaviors.insert(all_behaviors.end(), pop_behavior_set.begin(), pop_behavior_set.end());          
+            all_behaviors.insert(all_behaviors.end(), columns.behavior.begin(), columns.behavior.end());          
             EvalPopulation(); 
             
             // // ---- NOVELTY SEARCH ----
@@ -412,7 +774,7 @@ public:
             // if (verbose) std::cout << "DEBUG Archive Size: " << archive.size() << std::endl;
 
             // // Concatenate archive and population behavior set
-            // emp::vector<std::pair<double, double>> combined_behaviors {pop_behavior_set};
+            // emp::vector<std::pair<double, double>> combined_behaviors {columns.behavior};
             // for (std::unique_ptr<Program> & prog_ptr : archive) {
             //     MazeProgram& prog = dynamic_cast<MazeProgram&>(*prog_ptr);
             //     combined_behaviors.emplace_back(prog.GetBehavior());
@@ -437,11 +799,7 @@ public:
             // if (verbose) os << "P_min: " << p_min << std::endl;
             // // ------------------------
 
-            auto best_it = std::max_element(population.begin(), population.end(),
-            [](std::unique_ptr<Program> const & a, std::unique_ptr<Program> const & b) {
-                return a->GetFitness() < b->GetFitness();
-            });
-            best_program = (*best_it)->Clone();
+            KeepCopy(best_program, *population[BestIndex(columns.fitness)]);
             best_fitness_history.emplace_back(best_program->GetFitness());
             avg_fitness_history.emplace_back(AvgFitness());
             median_fitness_history.emplace_back(MedianFitness());
@@ -449,11 +807,7 @@ public:
 
             // Secondary fitness metrics
             if (second_evaluator) {
-                auto best_it2 = std::max_element(population.begin(), population.end(),
-                [](std::unique_ptr<Program> const & a, std::unique_ptr<Program> const & b) {
-                    return a->GetSecondFitness() < b->GetSecondFitness();
-                });
-                best_program2 = (*best_it2)->Clone();
+                KeepCopy(best_program2, *population[BestIndex(columns.second_fitness)]);
                 second_best_fitness_history.emplace_back(best_program2->GetSecondFitness());
                 second_avg_fitness_history.emplace_back(AvgSecondFitness());
                 second_median_fitness_history.emplace_back(MedianSecondFitness());
@@ -473,10 +827,13 @@ public:
             // semantic_intron_history.emplace_back(AvgSemanticIntronProp());
             // semantic_intron_elim_history.emplace_back(AvgSemanticIntronProp_Elimination());
             // structural_intron_history.emplace_back(AvgStructuralIntronProp());
+
+            if (AllocationCounter::enabled) allocation_history.push_back(AllocationCounter::Count() - generation_allocations);
         }
         
         if (verbose) {
             os << "\nEvolution complete (^_^)!\nOverall Best Fitness: " << best_program->GetFitness() << "\n";
+            if (use_cache) os << "Fitness Cache Hit Rate: " << cache.HitRate() << "\n";
         }
 
         // // ---- COMMENT IF MULTI-RUN ----
@@ -504,60 +861,90 @@ public:
             rng.seed(i);
             Reset();
             Evolve();
-            ExportFitnessHistory("fitness_run_" + std::to_string(i) + ".csv");
-            ExportAllBehaviors("all_behaviors" + std::to_string(i) + ".csv");
-            // ExportEffectHistory("effect_run_" + std::to_string(i) + ".csv");
-            // ExportIntronHistory("intron_run_" + std::to_string(i) + ".csv");
+            ExportRun(i, os);
+        }        
+    }
 
-            // ---- FOR TEST SET EVALUATION ----
-            std::ofstream ofs("best_program_" + std::to_string(i) + ".txt");
-            if (ofs.is_open()) {
-                // ofs << best_program->GetFitness() << "\n";
-                ofs << *best_program;
-            }
+    // Runs the replicates of MultiRunEvolve() side by side, on 'threads' threads (0 = one per
+    // hardware thread), and writes the same files
+    // Each replicate has its own population, histories and random stream (see ReplicateStream),
+    // seeded from SEED and its index, so results don't depend on the thread count. They do differ
+    // from MultiRunEvolve(), where each run picks up the generators where the last one left off.
+    // The evaluator, selector, variators and prototype are shared and only read, so the evaluator
+    // must be safe to call concurrently (as with SetThreadCount()). Each replicate starts from a
+    // copy of the fitness cache; replicates don't use this estimator's threads.
+    void ParallelMultiRunEvolve(int run_count=10, size_t threads=0, std::ostream & os=std::cout) {
+        ThreadPool replicate_pool(threads);
+        std::mutex os_mutex;
+        replicate_pool.ParallelFor(run_count, [&](size_t i) {
+            std::seed_seq seq {static_cast<unsigned>(SEED), static_cast<unsigned>(i)};
+            std::mt19937 stream(seq);
+            ReplicateStream use_stream(stream);
+
+            BasicEstimator replicate(*this, os);
+            replicate.rng.seed(i);
+            replicate.Evolve();
+
+            std::lock_guard<std::mutex> lock(os_mutex);
+            replicate.ExportRun(i, os);
+        });
+    }
 
-            // // ---- FOR OBJECTIVE SEARCH ONLY (TO ISOLATE SUFFICIENTLY DIFFICULT MAZES) ----
-            // if (!second_evaluator) { // objective search only
-            //     MazeEvaluator & eval = dynamic_cast<MazeEvaluator&>(*evaluator);
-            //     std::vector<double> maze_dists = eval.EvaluatePerMaze(*best_program);
-                
-            //     // store best program's performance on individual mazes
-            //     std::ofstream dist_ofs("maze_dists_run_" + std::to_string(i) + ".csv"); 
-            //     std::string maze_dir = "hard_mazes_run_" + std::to_string(i);
-            //     std::filesystem::create_directory(maze_dir);
-            
-            //     std::vector<MazeEnvironment> const & mazes = eval.GetInputMazes();
-            
-            //     for (size_t j = 0; j < maze_dists.size(); ++j) {
-            //         dist_ofs << j << "," << maze_dists[j] << "\n";
+    // Files and summary for run 'i' of a multi-run
+    void ExportRun(int i, std::ostream & os) const {
+        ExportFitnessHistory("fitness_run_" + std::to_string(i) + ".csv");
+        ExportAllBehaviors("all_behaviors" + std::to_string(i) + ".csv");
+        // ExportEffectHistory("effect_run_" + std::to_string(i) + ".csv");
+        // ExportIntronHistory("intron_run_" + std::to_string(i) + ".csv");
+
+        // ---- FOR TEST SET EVALUATION ----
+        std::ofstream ofs("best_program_" + std::to_string(i) + ".txt");
+        if (ofs.is_open()) {
+            // ofs << best_program->GetFitness() << "\n";
+            ofs << *best_program;
+        }
+
+        // // ---- FOR OBJECTIVE SEARCH ONLY (TO ISOLATE SUFFICIENTLY DIFFICULT MAZES) ----
+        // if (!second_evaluator) { // objective search only
+        //     MazeEvaluator & eval = dynamic_cast<MazeEvaluator&>(*evaluator);
+        //     std::vector<double> maze_dists = eval.EvaluatePerMaze(*best_program);
             
-            //         if (maze_dists[j] > 20) { // agent does poorly on maze
-            //             std::string filename = maze_dir + "/maze_" + std::to_string(j) + ".txt";
-            //             mazes[j].SaveMaze(filename);
-            //         }
-            //     }
-            // }
+        //     // store best program's performance on individual mazes
+        //     std::ofstream dist_ofs("maze_dists_run_" + std::to_string(i) + ".csv"); 
+        //     std::string maze_dir = "hard_mazes_run_" + std::to_string(i);
+        //     std::filesystem::create_directory(maze_dir);
+        
+        //     std::vector<MazeEnvironment> const & mazes = eval.GetInputMazes();
+        
+        //     for (size_t j = 0; j < maze_dists.size(); ++j) {
+        //         dist_ofs << j << "," << maze_dists[j] << "\n";
+        
+        //         if (maze_dists[j] > 20) { // agent does poorly on maze
+        //             std::string filename = maze_dir + "/maze_" + std::to_string(j) + ".txt";
+        //             mazes[j].SaveMaze(filename);
+        //         }
+        //     }
+        // }
 
 
-            if (second_evaluator) {
-                ExportSecondHistory("second_fitness_run_" + std::to_string(i) + ".csv");
-                ExportArchiveBehaviors("behavior_archive_" + std::to_string(i) + ".txt");
-                ExportPMinHistory("p_min_history_" + std::to_string(i) + ".csv");
-
-                std::ofstream ofs("best_program2_" + std::to_string(i) + ".txt");
-                if (ofs.is_open()) {
-                    // ofs << best_program2->GetFitness() << "\n";
-                    ofs << *best_program2;
-                }
-            }
+        if (second_evaluator) {
+            ExportSecondHistory("second_fitness_run_" + std::to_string(i) + ".csv");
+            ExportArchiveBehaviors("behavior_archive_" + std::to_string(i) + ".txt");
+            ExportPMinHistory("p_min_history_" + std::to_string(i) + ".csv");
 
-            if (second_evaluator) {
-                os << "Best novelty: " << best_program->GetFitness() << "\n";
-                os << "Best objective: " << best_program2->GetSecondFitness() << "\n";
+            std::ofstream ofs("best_program2_" + std::to_string(i) + ".txt");
+            if (ofs.is_open()) {
+                // ofs << best_program2->GetFitness() << "\n";
+                ofs << *best_program2;
             }
-            
-            os << "Finished run " << i << "\n";
-        }        
+        }
+
+        if (second_evaluator) {
+            os << "Best novelty: " << best_program->GetFitness() << "\n";
+            os << "Best objective: " << best_program2->GetSecondFitness() << "\n";
+        }
+        
+        os << "Finished run " << i << "\n";
     }
 
     void PrintRunParam(std::ostream & os) const {
@@ -642,7 +1029,7 @@ public:
     }
 
     void ExportBestProgram(std::string const & filename="best_program.txt") const {
-        MazeProgram & best_prog {dynamic_cast<MazeProgram&>(*best_program)};
+        MazeProgramBase & best_prog {dynamic_cast<MazeProgramBase&>(*best_program)};
         std::ofstream ofs(filename);
         if (ofs.is_open()) {
             // Maze Program only :') 
@@ -676,7 +1063,7 @@ public:
         std::ofstream ofs(filename);
         if (ofs.is_open()) {
             for (size_t i {0}; i < archive.size(); ++i) {
-                MazeProgram & prog {dynamic_cast<MazeProgram&>(*archive[i])};
+                MazeProgramBase & prog {dynamic_cast<MazeProgramBase&>(*archive[i])};
                 ofs << "Program " << i << "\n" << prog
                 << "\nFinal Row: " << prog.GetBehaviorR()
                 << "\nFinal Col: " << prog.GetBehaviorC()
@@ -699,4 +1086,7 @@ public:
     // ------------------------
 };
 
-#endif
\ No newline at end of file
+// Type-erased estimator: any Program, Evaluator, Selector and list of Variators
+using Estimator = BasicEstimator<Program, Evaluator, Selector>;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+#ifndef FITNESS_CACHE_HPP
+#define FITNESS_CACHE_HPP
+
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+#include <optional>
+#include <unordered_map>
+
+#include "emp/base/vector.hpp"
+
+// Fitnesses and behaviors already computed, keyed by Program::CanonicalHash()
+// Only valid for one evaluator and training set; the Estimator keeps one per evaluator.
+// With a size bound, the oldest entries are dropped first, and a full cache reuses the dropped
+// entry's storage for the new one, so it stops allocating once it is full.
+class FitnessCache {
+public:
+    struct Entry {
+        std::optional<double> fitness;
+        std::optional<std::pair<double, double>> behavior;
+    };
+
+private:
+    std::unordered_map<std::uint64_t, Entry> entries;
+    // Keys in insertion order, oldest first starting at order[oldest] and wrapping around
+    // (oldest is only nonzero once a bounded cache is full)
+    emp::vector<std::uint64_t> order;
+    size_t oldest {0};
+    size_t max_entries {0}; // 0 = unbounded
+
+    size_t hits {0};
+    size_t misses {0};
+
+    Entry * Find(std::uint64_t key) {
+        auto it {entries.find(key)};
+        return it == entries.end() ? nullptr : &it->second;
+    }
+
+    Entry & FindOrInsert(std::uint64_t key) {
+        if (Entry * e {Find(key)}) return *e;
+        if (max_entries > 0 && entries.size() >= max_entries) {
+            // Full: the oldest entry's node becomes the new one
+            auto node {entries.extract(order[oldest])};
+            node.key() = key;
+            node.mapped() = Entry{};
+            order[oldest] = key;
+            oldest = (oldest + 1) % order.size();
+            return entries.insert(std::move(node)).position->second;
+        }
+        order.push_back(key);
+        return entries[key];
+    }
+
+    template <typename V>
+    std::optional<V> Count(std::optional<V> const & value) {
+        if (value) ++hits;
+        else ++misses;
+        return value;
+    }
+
+public:
+    FitnessCache(size_t max=0) : max_entries(max) { }
+
+    std::optional<double> FindFitness(std::uint64_t key) {
+        Entry * e {Find(key)};
+        return Count(e ? e->fitness : std::nullopt);
+    }
+
+    std::optional<std::pair<double, double>> FindBehavior(std::uint64_t key) {
+        Entry * e {Find(key)};
+        return Count(e ? e->behavior : std::nullopt);
+    }
+
+    void StoreFitness(std::uint64_t key, double f) { FindOrInsert(key).fitness = f; }
+    void StoreBehavior(std::uint64_t key, std::pair<double, double> b) { FindOrInsert(key).behavior = b; }
+
+    // Also counts as a hit: used for duplicates within a batch, which are only evaluated once
+    void CountHit() { ++hits; }
+
+    void SetMaxEntries(size_t max) {
+        max_entries = max;
+        std::rotate(order.begin(), order.begin() + oldest, order.end());
+        oldest = 0;
+        if (max_entries > 0 && order.size() > max_entries) {
+            size_t const excess {order.size() - max_entries};
+            for (size_t i {0}; i < excess; ++i) entries.erase(order[i]);
+            order.erase(order.begin(), order.begin() + excess);
+        }
+        if (max_entries > 0) {
+            order.reserve(max_entries);
+            entries.reserve(max_entries);
+        }
+    }
+
+    size_t Size() const { return entries.size(); }
+    size_t GetHits() const { return hits; }
+    size_t GetMisses() const { return misses; }
+    double HitRate() const {
+        return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+    }
+
+    void Clear() {
+        entries.clear();
+        order.clear();
+        oldest = 0;
+        ResetStats();
+    }
+    void ResetStats() { hits = misses = 0; }
+};
+
+#endif
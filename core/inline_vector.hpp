@@ -0,0 +1,75 @@
+#ifndef INLINE_VECTOR_HPP
+#define INLINE_VECTOR_HPP
+
+// A vector with a compile-time capacity, stored inline in a std::array.
+// Copying one is a plain copy of the array (no allocation), which makes cloning programs cheap.
+// InlineStorage<T, CAP> picks InlineVector for CAP > 0 and emp::vector (any size) for CAP == 0.
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+#include "emp/base/vector.hpp"
+
+template <typename T, size_t CAP>
+class InlineVector {
+private:
+    std::array<T, CAP> items {};
+    size_t count {0};
+
+public:
+    using value_type = T;
+    using iterator = T *;
+    using const_iterator = T const *;
+
+    InlineVector() = default;
+    InlineVector(size_t n, T const & val = T{}) { resize(n, val); }
+
+    static constexpr size_t capacity() { return CAP; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T & operator[](size_t i) { return items[i]; }
+    T const & operator[](size_t i) const { return items[i]; }
+
+    T * data() { return items.data(); }
+    T const * data() const { return items.data(); }
+
+    iterator begin() { return items.data(); }
+    iterator end() { return items.data() + count; }
+    const_iterator begin() const { return items.data(); }
+    const_iterator end() const { return items.data() + count; }
+
+    void clear() { count = 0; }
+
+    // Nothing to allocate; only checks that 'n' fits, like resize()
+    void reserve(size_t n) const {
+        if (n > CAP) throw std::length_error("InlineVector capacity exceeded.");
+    }
+
+    void push_back(T const & val) {
+        if (count == CAP) throw std::length_error("InlineVector is full.");
+        items[count++] = val;
+    }
+
+    void resize(size_t n, T const & val = T{}) {
+        if (n > CAP) throw std::length_error("InlineVector capacity exceeded.");
+        for (size_t i {count}; i < n; ++i) items[i] = val;
+        count = n;
+    }
+
+    template <typename It>
+    void assign(It first, It last) {
+        size_t const n {static_cast<size_t>(std::distance(first, last))};
+        if (n > CAP) throw std::length_error("InlineVector capacity exceeded.");
+        for (size_t i {0}; first != last; ++first, ++i) items[i] = *first;
+        count = n;
+    }
+};
+
+template <typename T, size_t CAP>
+using InlineStorage = std::conditional_t<CAP == 0, emp::vector<T>, InlineVector<T, CAP>>;
+
+#endif
@@ -1,10 +1,10 @@
 #ifndef INSTRUCTIONS_HPP
 #define INSTRUCTIONS_HPP
 
-#include <variant>
-#include <optional>
+#include <cstdint>
+#include <cstddef>
 
-enum class RkType {
+enum class RkType : std::uint8_t {
     REGISTER,
     CONSTANT
 };
@@ -14,25 +14,34 @@ enum class RegisterType {
    READ_ONLY 
 };
 
+// Operands are stored as single bytes, so register files are capped at this size
+constexpr size_t MAX_REGISTER_COUNT = 256;
+
 struct Instruction {
     // Instructions are representd as r[i] = op (r[j] r[k])
-    // Operators are determined using strings
+    // Operators are determined by their index in the global operator set
     // Two possibilities for r[k] - register or constant.
     // Because we're using numbers to represent registers, we need a way to differentiate
     // Use a flag to differentiate between constant values and register ID
-        // ('reg', 2): Register 2
-        // ('const', 2): Constant 
-    size_t Ri, Rj; // Index of registers
-    RkType Rk_type;
-    std::variant<size_t, double> Rk; // 'size_t' for index, 'double' for constant
-    size_t op; // Index of operator in global operators set
+        // (REGISTER, 2): Register 2
+        // (CONSTANT, 2): Constant #2 in the global constant pool (GLOBAL_CONSTANTS)
+    // Everything is packed into 8 bytes (plain data, no variant/optional) so that genomes
+    // are cheap to copy and bounds are checked once, when a program's instructions are set
+    std::uint8_t op {0}; // Index of operator in global operators set (or ternary set)
+    std::uint8_t op_type {0}; // 0 = unary/binary, 1 = ternary
+    std::uint8_t Ri {0}, Rj {0}; // Index of registers
 
     // TERNARY-ONLY
     // Instructions can now look like this: r[i] = op (r[j] r[t] r[k])
-    std::optional<size_t> Rt; // for index of Register...Ternary
+    std::uint8_t Rt {0}; // for index of Register...Ternary, ignored if op_type == 0
+
+    RkType Rk_type {RkType::REGISTER};
+    std::uint16_t Rk {0}; // register index or constant pool index
 
-    size_t op_type; // 0 = unary/binary, 1 = ternary
+    friend bool operator==(Instruction const &, Instruction const &) = default;
 };
 
+static_assert(sizeof(Instruction) == 8, "Instruction is expected to pack into 8 bytes.");
+
 
-#endif
\ No newline at end of file
+#endif
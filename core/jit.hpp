@@ -0,0 +1,272 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+// Native x86-64 backend: compiles a program's (effective) instructions into SSE2 machine code.
+// The generated function has the signature void(double * registers, double const * constants)
+// (System V calling convention: registers in rdi, constant table in rsi). Every instruction
+// loads its operands from the register file, computes the result in xmm registers, clamps it
+// to [-1e6, 1e6] exactly like std::clamp (NaN included) and stores it back. Everything is
+// branch-free.
+//
+// Only the built-in operators can be compiled. Compile() returns nullptr for code that uses a
+// user-registered operator (or on platforms without the backend), and the caller should fall
+// back to the interpreter.
+
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <memory>
+#include <random>
+#include <algorithm>
+
+#include "emp/base/vector.hpp"
+
+#include "instructions.hpp"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define KARLGP_JIT_AVAILABLE 1
+#include <sys/mman.h>
+#endif
+
+class JitCode {
+private:
+    using jit_func = void (*)(double *, double const *);
+
+    void * buffer {nullptr};
+    size_t buffer_size {0};
+    jit_func func {nullptr};
+    // Fixed slots first, then one slot per constant operand
+    emp::vector<double> constants;
+
+    static constexpr int LO {0}, HI {1}, ONE {2}, ZERO {3};
+
+    // ---- ENCODING ----
+    // Only xmm0-xmm7 and rdi/rsi are used, so no REX prefixes are needed
+    static constexpr int RSI {6}, RDI {7};
+
+    emp::vector<std::uint8_t> code;
+
+    void Byte(std::uint8_t b) { code.push_back(b); }
+
+    void Disp32(std::int32_t d) {
+        for (int i {0}; i < 4; ++i) Byte(static_cast<std::uint8_t>((d >> (8 * i)) & 0xFF));
+    }
+
+    // prefix 0F opcode, with xmm 'reg' and memory operand [base + disp32]
+    void SseMem(std::uint8_t prefix, std::uint8_t opcode, int reg, int base, std::int32_t disp) {
+        Byte(prefix); Byte(0x0F); Byte(opcode);
+        Byte(static_cast<std::uint8_t>(0x80 | (reg << 3) | base));
+        Disp32(disp);
+    }
+
+    // prefix 0F opcode, between xmm registers
+    void SseReg(std::uint8_t prefix, std::uint8_t opcode, int dst, int src) {
+        Byte(prefix); Byte(0x0F); Byte(opcode);
+        Byte(static_cast<std::uint8_t>(0xC0 | (dst << 3) | src));
+    }
+
+    void LoadReg(int xmm, size_t r) { SseMem(0xF2, 0x10, xmm, RDI, static_cast<std::int32_t>(8 * r)); } // movsd
+    void LoadConst(int xmm, size_t c) { SseMem(0xF2, 0x10, xmm, RSI, static_cast<std::int32_t>(8 * c)); } // movsd
+    void Store(size_t r, int xmm) { SseMem(0xF2, 0x11, xmm, RDI, static_cast<std::int32_t>(8 * r)); } // movsd
+
+    void Add(int d, int s) { SseReg(0xF2, 0x58, d, s); } // addsd
+    void Mul(int d, int s) { SseReg(0xF2, 0x59, d, s); } // mulsd
+    void Sub(int d, int s) { SseReg(0xF2, 0x5C, d, s); } // subsd
+    void Min(int d, int s) { SseReg(0xF2, 0x5D, d, s); } // minsd: d = (d < s) ? d : s
+    void Div(int d, int s) { SseReg(0xF2, 0x5E, d, s); } // divsd
+    void Max(int d, int s) { SseReg(0xF2, 0x5F, d, s); } // maxsd: d = (d > s) ? d : s
+    void And(int d, int s) { SseReg(0x66, 0x54, d, s); } // andpd
+    void AndNot(int d, int s) { SseReg(0x66, 0x55, d, s); } // andnpd: d = ~d & s
+    void Or(int d, int s) { SseReg(0x66, 0x56, d, s); } // orpd
+    void Xor(int d, int s) { SseReg(0x66, 0x57, d, s); } // xorpd
+    void Move(int d, int s) { SseReg(0x66, 0x28, d, s); } // movapd
+
+    // d = all ones if (0 < s), else all zeros; false for NaN, like Operators::AsBool()
+    void IsPositive(int d, int s) {
+        Xor(d, d);
+        SseReg(0xF2, 0xC2, d, s); Byte(1); // cmpltsd d, s
+    }
+
+    // d = all ones if (d != [rsi + 8*c]), true for NaN like the != operator
+    void NotEqualConst(int d, size_t c) {
+        SseMem(0xF2, 0xC2, d, RSI, static_cast<std::int32_t>(8 * c)); Byte(4); // cmpneqsd
+    }
+
+    // std::clamp(v, lo, hi) = (v < lo) ? lo : ((hi < v) ? hi : v), NaN passes through
+    // Returns the xmm register holding the result
+    int Clamp(int v) {
+        LoadConst(6, LO);
+        Max(6, v); // (lo > v) ? lo : v
+        LoadConst(7, HI);
+        Min(7, 6); // (hi < x) ? hi : x
+        return 7;
+    }
+
+    // Emits one instruction, returns false if it can't be compiled
+    bool EmitInstruction(Instruction const & instr) {
+        // xmm0 = r[j], xmm1 = r[k], xmm2 = r[t] (ternary)
+        LoadReg(0, instr.Rj);
+        if (instr.Rk_type == RkType::CONSTANT) {
+            constants.push_back(GLOBAL_CONSTANTS.GetConstant(instr.Rk));
+            LoadConst(1, constants.size() - 1);
+        }
+        else {
+            LoadReg(1, instr.Rk);
+        }
+
+        int result {0};
+        if (instr.op_type == 1) {
+            if (GLOBAL_OPERATORS.GetTernaryOpCode(instr.op) != OpCode::IF3) return false;
+            LoadReg(2, instr.Rt);
+            IsPositive(3, 0);
+            And(2, 3); // mask & r[t]
+            AndNot(3, 1); // ~mask & r[k]
+            Or(2, 3);
+            result = Clamp(2);
+        }
+        else {
+            OpCode const code {GLOBAL_OPERATORS.GetOpCode(instr.op)};
+            switch (code) {
+                case OpCode::ADD: Add(0, 1); result = Clamp(0); break;
+                case OpCode::SUB: Sub(0, 1); result = Clamp(0); break;
+                case OpCode::MULT: Mul(0, 1); result = Clamp(0); break;
+                case OpCode::DIV: // (b != 0) ? a / b : 1.0
+                    Move(2, 1);
+                    NotEqualConst(2, ZERO);
+                    Div(0, 1);
+                    And(0, 2);
+                    LoadConst(3, ONE);
+                    AndNot(2, 3);
+                    Or(0, 2);
+                    result = Clamp(0);
+                    break;
+                case OpCode::IF: // AsBool(a) ? b : 0.0
+                    IsPositive(2, 0);
+                    And(2, 1);
+                    result = Clamp(2);
+                    break;
+                case OpCode::AND: case OpCode::OR: case OpCode::NAND: case OpCode::NOR:
+                case OpCode::XOR: case OpCode::GREATER: case OpCode::EQUAL: case OpCode::LESS:
+                case OpCode::NOT:
+                    // xmm2 = AsBool(a), xmm3 = AsBool(b) as masks, xmm4 = 1.0
+                    // Results are 0.0 or 1.0, so they don't need clamping
+                    IsPositive(2, 0);
+                    IsPositive(3, 1);
+                    LoadConst(4, ONE);
+                    switch (code) {
+                        case OpCode::AND: And(2, 3); And(2, 4); result = 2; break;
+                        case OpCode::OR: Or(2, 3); And(2, 4); result = 2; break;
+                        case OpCode::NAND: And(2, 3); AndNot(2, 4); result = 2; break;
+                        case OpCode::NOR: Or(2, 3); AndNot(2, 4); result = 2; break;
+                        case OpCode::XOR: Xor(2, 3); And(2, 4); result = 2; break;
+                        case OpCode::EQUAL: Xor(2, 3); AndNot(2, 4); result = 2; break;
+                        case OpCode::GREATER: AndNot(3, 2); And(3, 4); result = 3; break; // a && !b
+                        case OpCode::LESS: AndNot(2, 3); And(2, 4); result = 2; break; // !a && b
+                        default: AndNot(2, 4); result = 2; break; // NOT
+                    }
+                    break;
+                default: // user-registered operator
+                    return false;
+            }
+        }
+        Store(instr.Ri, result);
+        return true;
+    }
+
+    JitCode() : constants {-1e6, 1e6, 1.0, 0.0} { }
+
+public:
+    JitCode(JitCode const &) = delete;
+    JitCode & operator=(JitCode const &) = delete;
+
+    ~JitCode() {
+#ifdef KARLGP_JIT_AVAILABLE
+        if (buffer) munmap(buffer, buffer_size);
+#endif
+    }
+
+    static bool IsAvailable() {
+#ifdef KARLGP_JIT_AVAILABLE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Returns nullptr if the code uses a user-registered operator or the platform isn't supported
+    // Instructions are assumed to be validated already (see SetInstructions())
+    // Compiled code is immutable, so it can be shared between copies of a program
+    static std::shared_ptr<JitCode const> Compile(std::span<Instruction const> instrs) {
+#ifdef KARLGP_JIT_AVAILABLE
+        std::shared_ptr<JitCode> jit {new JitCode()};
+        for (Instruction const & instr : instrs) {
+            if (!jit->EmitInstruction(instr)) return nullptr;
+        }
+        jit->Byte(0xC3); // ret
+
+        jit->buffer_size = jit->code.size();
+        void * mem {mmap(nullptr, jit->buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)};
+        if (mem == MAP_FAILED) return nullptr;
+        std::memcpy(mem, jit->code.data(), jit->code.size());
+        if (mprotect(mem, jit->buffer_size, PROT_READ | PROT_EXEC) != 0) {
+            munmap(mem, jit->buffer_size);
+            return nullptr;
+        }
+        jit->buffer = mem;
+        jit->func = reinterpret_cast<jit_func>(mem);
+        jit->code.clear();
+        jit->code.shrink_to_fit();
+        return jit;
+#else
+        (void) instrs;
+        return nullptr;
+#endif
+    }
+
+    // 'registers' must be at least as large as the register file the code was compiled for
+    void Run(double * registers) const {
+        func(registers, constants.data());
+    }
+
+    // Runs the compiled code and a plain interpreter on the same random register files
+    // and checks that they agree bit for bit (NaNs only need to agree on being NaN)
+    bool Verify(std::span<Instruction const> instrs, size_t register_count,
+        size_t trials=100, unsigned seed=0) const {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> val_dist(-10.0, 10.0);
+        std::uniform_int_distribution<int> kind_dist(0, 4);
+
+        emp::vector<double> jit_regs(register_count), ref_regs(register_count);
+        for (size_t trial {0}; trial < trials; ++trial) {
+            for (double & r : ref_regs) {
+                // Mix in zeros, whole numbers and huge values to hit the protected/clamped paths
+                switch (kind_dist(rng)) {
+                    case 0: r = 0.0; break;
+                    case 1: r = std::round(val_dist(rng)); break;
+                    case 2: r = val_dist(rng) * 1e6; break;
+                    default: r = val_dist(rng); break;
+                }
+            }
+            jit_regs = ref_regs;
+
+            Run(jit_regs.data());
+            for (Instruction const & instr : instrs) {
+                double Rk_value {instr.Rk_type == RkType::CONSTANT ?
+                    GLOBAL_CONSTANTS.GetConstant(instr.Rk) : ref_regs[instr.Rk]};
+                double val {instr.op_type == 1 ?
+                    GLOBAL_OPERATORS.ApplyTernary(instr.op, ref_regs[instr.Rj], ref_regs[instr.Rt], Rk_value) :
+                    GLOBAL_OPERATORS.Apply(instr.op, ref_regs[instr.Rj], Rk_value)};
+                ref_regs[instr.Ri] = std::clamp(val, -1e6, 1e6);
+            }
+
+            for (size_t r {0}; r < register_count; ++r) {
+                if (std::isnan(jit_regs[r]) && std::isnan(ref_regs[r])) continue;
+                if (std::memcmp(&jit_regs[r], &ref_regs[r], sizeof(double)) != 0) return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,773 @@
+#ifndef LINEAR_PROG_HPP
+#define LINEAR_PROG_HPP
+
+// The linear GP core shared by every program domain (ArithmeticProgram, MazeProgram, ...)
+// A program is a list of register machine instructions, r[i] = op (r[j] r[k]), or
+// r[i] = op (r[j] r[t] r[k]) for ternary operators. Domains only differ in where their inputs
+// and output live and in whether registers survive from one run to the next, which is what
+// RegisterLayout describes. Initialization, validation, effective code, the execution engines,
+// batch execution and printing/loading live here, so they are written (and tuned) once.
+//  - LinearProgramBase: everything that depends on neither the register type nor the program size
+//  - Domain bases (ArithmeticProgramBase, MazeProgramBase) derive from it with their layout and
+//    domain-only state (e.g., maze behavior); evaluators cast to those
+//  - LinearProgram<Base, T, R, L>: the registers and instructions, on top of a domain base
+
+#include <bit>
+#include <span>
+#include <cmath>
+#include <bitset>
+#include <numeric>
+#include <memory>
+#include <random>
+#include <string>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <optional>
+#include <typeinfo>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "emp/base/vector.hpp"
+
+#include "base_prog.hpp"
+#include "numeric.hpp"
+#include "batch_exec.hpp"
+#include "inline_vector.hpp"
+#include "threaded_code.hpp"
+#include "jit.hpp"
+
+class LinearProgramBase : public Program {
+protected:
+    RegisterLayout layout;
+    size_t register_count, program_length;
+    double rk_prob {0.3}; // Hard-coded, probability of including constant over register
+
+    std::optional<double> fitness;
+    std::optional<double> second_fitness; // Secondary fitness, does not effect selection
+
+    std::mt19937 rng; // Random number generator
+
+    // Doesn't call InitProgram(), LinearProgram does once its registers exist
+    LinearProgramBase(RegisterLayout const & lay, size_t rc, size_t pl)
+    : layout(lay), register_count(std::max(rc, lay.MinRegisterCount())), program_length(pl), rng(SEED) {
+        assert(register_count <= MAX_REGISTER_COUNT && "Too many registers.");
+    }
+
+public:
+    using Program::Input;
+    // One value per input register
+    virtual void Input(emp::vector<double> const & inputs) = 0;
+
+    // Instructions that can affect the output register, in program order
+    virtual std::span<Instruction const> GetEffectiveInstructions() const = 0;
+
+    // For analysis code that steps through a program by hand (see SemanticIntronProp())
+    virtual void ExecuteInstruction(Instruction const & instr) = 0;
+    virtual double GetRegister(size_t r) const = 0;
+
+    RegisterLayout const & GetLayout() const { return layout; }
+    size_t GetRegisterCount() const { return register_count; }
+    size_t GetProgramLength() const { return program_length; }
+
+    bool IsEvaluated() const override { return fitness.has_value(); }
+    double GetFitness() const override {
+        if (!fitness) throw std::runtime_error("Fitness has not been evaluated.");
+        return fitness.value();
+    }
+    void SetFitness(double val) override { fitness = val; }
+    void ResetFitness() override { fitness.reset(); }
+
+    bool IsSecondEvaluated() const override { return second_fitness.has_value(); }
+    double GetSecondFitness() const override {
+        if (!second_fitness) throw std::runtime_error("Secondary fitness has not been evaluated.");
+        return second_fitness.value();
+    }
+    void SetSecondFitness(double val) override { second_fitness = val; }
+    void ResetSecondFitness() override { second_fitness.reset(); }
+
+    // Operands are checked once here so that ExecuteInstruction() can skip bounds checks
+    void ValidateInstructions(std::span<Instruction const> instrs) const {
+        for (Instruction const & instr : instrs) {
+            bool valid {instr.Ri < register_count && instr.Rj < register_count};
+            if (instr.op_type == 0) valid = valid && instr.op < GLOBAL_OPERATORS.Size();
+            else valid = valid && instr.op_type == 1 && instr.Rt < register_count &&
+                instr.op < GLOBAL_OPERATORS.TernarySize();
+            if (instr.Rk_type == RkType::REGISTER) valid = valid && instr.Rk < register_count;
+            else valid = valid && instr.Rk < GLOBAL_CONSTANTS.Size();
+            if (!valid) throw std::runtime_error("Invalid instruction for this program.");
+        }
+    }
+
+    // Marks the instructions that can affect the output register, going backwards
+    // This implementation is missing step 3 for control flow operations
+    // If the layout carries registers over between runs, a register that is read before it is
+    // written gets its value from the previous run, so it is also live at the end of the program
+    // (except for the inputs, which Input() overwrites every run). Otherwise one pass is enough.
+    // is_effective_instruct[i]: instrs[i] is effective (resized to fit; doesn't allocate once it's big enough)
+    template <typename Mask>
+    void FindEffectiveInstructions(std::span<Instruction const> instrs, Mask & is_effective_instruct) const {
+        std::bitset<MAX_REGISTER_COUNT> live_at_end;
+        live_at_end[layout.output] = true;
+        is_effective_instruct.clear();
+        is_effective_instruct.resize(instrs.size(), false);
+
+        // Repeat until the set of carried-over registers stops growing
+        bool changed {true};
+        while (changed) {
+            std::bitset<MAX_REGISTER_COUNT> effective_registers {live_at_end};
+
+            // Go backwards through program
+            for (size_t i {instrs.size()}; i-- > 0; ) {
+                Instruction const & temp {instrs[i]};
+                // If instruction writes to an effective register, mark it as effective
+                if (!effective_registers[temp.Ri]) continue;
+                is_effective_instruct[i] = true;
+                // Insert operand registers into the effective set
+                effective_registers[temp.Rj] = true;
+                if (temp.op_type == 1) effective_registers[temp.Rt] = true;
+                if (temp.Rk_type == RkType::REGISTER) effective_registers[temp.Rk] = true;
+            }
+
+            changed = false;
+            if (!layout.carry_registers) break;
+            for (size_t r {0}; r < register_count; ++r) {
+                if (effective_registers[r] && !live_at_end[r] && !layout.IsInput(r)) {
+                    live_at_end[r] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Calculates proportion of structural introns in a single program
+    double StructuralIntronProp() const override {
+        return 1.0 - static_cast<double>(GetEffectiveInstructions().size()) / program_length;
+    }
+
+    void PrintProgram(std::ostream & os) const override {
+        for (Instruction const & instr : GetInstructions()) {
+            os << "r[" << +instr.Ri << "] = ";
+
+            if (instr.op_type == 0) os << GLOBAL_OPERATORS.GetOperatorName(instr.op);
+            else os << GLOBAL_OPERATORS.GetTernaryOperatorName(instr.op);
+
+            os << " (r[" << +instr.Rj << "], ";
+
+            if (instr.op_type == 1) {
+                os << "r[" << +instr.Rt << "], ";
+            }
+
+            if (instr.Rk_type == RkType::REGISTER) {
+                os << "r[" << instr.Rk << "])\n";
+            }
+            else if (instr.Rk_type == RkType::CONSTANT) {
+                os << GLOBAL_CONSTANTS.GetConstant(instr.Rk) << ")\n";
+            }
+        }
+    }
+
+    // Reads a program written by PrintProgram()
+    void LoadProgram(std::string const & filename) {
+        std::ifstream ifs(filename);
+        if (!ifs.is_open()) throw std::runtime_error("Could not open program file " + filename);
+
+        // Indices are range-checked before they're narrowed into Instruction's byte fields, so
+        // e.g. r[300] is rejected instead of wrapping around to r[44]
+        auto parse_register = [](std::string const & token) {
+            unsigned long const r {std::stoul(token)};
+            if (r >= MAX_REGISTER_COUNT) throw std::runtime_error("Register index out of range: " + token);
+            return static_cast<std::uint8_t>(r);
+        };
+
+        emp::vector<Instruction> instrs;
+        std::string line;
+        while (std::getline(ifs, line)) {
+            if (line.empty()) continue;
+
+            std::stringstream ss(line);
+            Instruction instr;
+
+            // Parse (binary): r[i] = OP (r[j], r[k]/constant)
+            // Parse (ternary): r[i] = OP (r[j], r[t], r[k]/constant)
+            std::string token;
+            std::getline(ss, token, '['); // "r"
+            std::getline(ss, token, ']');
+            instr.Ri = parse_register(token);
+
+            std::getline(ss, token, '('); // " = OP"
+            std::istringstream token_stream(token);
+            std::string equals, op_name;
+            token_stream >> equals >> op_name;
+
+            instr.op_type = GLOBAL_OPERATORS.IsTernaryOperator(op_name) ? 1 : 0;
+            if (!instr.op_type && !GLOBAL_OPERATORS.IsOperator(op_name)) {
+                throw std::runtime_error("Unknown operator: " + op_name);
+            }
+            size_t const op {instr.op_type ? GLOBAL_OPERATORS.GetTernaryOperatorID(op_name)
+                                           : GLOBAL_OPERATORS.GetOperatorID(op_name)};
+            if (op > UINT8_MAX) throw std::runtime_error("Operator index out of range: " + op_name);
+            instr.op = static_cast<std::uint8_t>(op);
+
+            std::getline(ss, token, '[');
+            std::getline(ss, token, ']');
+            instr.Rj = parse_register(token);
+
+            if (instr.op_type == 1) {
+                std::getline(ss, token, '[');
+                std::getline(ss, token, ']');
+                instr.Rt = parse_register(token);
+            }
+
+            // Parse r[k] or constant
+            std::getline(ss, token, ')');
+            std::stringstream final(token);
+            final >> token >> token;
+
+            if (token.find("r[") != std::string::npos) {
+                size_t start = token.find('[') + 1;
+                size_t end = token.find(']');
+                instr.Rk_type = RkType::REGISTER;
+                instr.Rk = parse_register(token.substr(start, end - start));
+            } else {
+                instr.Rk_type = RkType::CONSTANT;
+                // Fits: the pool refuses more constants than a 16-bit index can address
+                instr.Rk = static_cast<std::uint16_t>(GLOBAL_CONSTANTS.GetConstantID(std::stod(token)));
+            }
+            instrs.emplace_back(std::move(instr));
+        }
+
+        SetInstructions(instrs);
+    }
+};
+
+// Register states of one batch run (see LinearProgram::ExecuteProgramBatchIncremental()),
+// saved at some instruction boundaries. Programs share them with their clones, so a child made
+// by a variator can restart from its parent's state instead of from scratch.
+template <typename T>
+struct BatchSnapshot {
+    double const * inputs {nullptr}; // the cases the run was over
+    size_t case_count {0};
+    emp::vector<Instruction> code; // the effective instructions that were run
+    // After running code[0, positions[i]), only the registers that the rest of the code reads
+    // and that have been written so far need to be saved (the others still hold their initial
+    // value or don't matter): those are saved[i], and states[i] holds their rows, in register order
+    // A child shares the states it inherits with its parent
+    emp::vector<size_t> positions;
+    emp::vector<std::bitset<MAX_REGISTER_COUNT>> saved;
+    emp::vector<std::shared_ptr<emp::vector<T> const>> states;
+};
+
+// Registers hold T (double, float or Fixed, see numeric.hpp); constants, inputs and outputs are
+// still doubles, converted on the way in/out. The threaded and JIT engines are double-only,
+// other register types always use the interpreter.
+// R and L are the register and instruction capacities: if nonzero, registers and instructions
+// are stored inline (see inline_vector.hpp), so copying/cloning a program doesn't allocate.
+// 0 means any size (heap-allocated).
+template <typename Base, typename T, size_t R=0, size_t L=0>
+class LinearProgram final : public Base {
+    static_assert(std::is_base_of_v<LinearProgramBase, Base>, "LinearProgram needs a LinearProgramBase.");
+
+private:
+    using N = NumericTraits<T>;
+
+    using Base::layout;
+    using Base::register_count;
+    using Base::program_length;
+    using Base::rk_prob;
+    using Base::rng;
+
+    InlineStorage<T, R> registers; // Holds register values
+
+    InlineStorage<Instruction, L> instructions; // Program instructions
+    // Rebuilt whenever 'instructions' changes; this is what ExecuteProgram() runs
+    InlineStorage<Instruction, L> effective_instructions;
+    InlineStorage<bool, L> effective_mask; // effective_mask[i]: instructions[i] is effective
+
+    // A program runs many times per evaluation, so by default its effective code is optimized
+    // (see peephole.hpp) and compiled to threaded code on first use; recompiled after the
+    // instructions change. The optimized code may move registers other than the inputs and
+    // output around, so GetRegisters() only means something for those when this engine is used.
+    // Held by value, so a program that is overwritten (see Assign()) recompiles into the storage
+    // it already has instead of allocating
+    ExecutionEngine engine {ExecutionEngine::THREADED};
+    BasicThreadedCode<L> threaded_code;
+    bool threaded_compiled {false};
+    // Set when the threaded code's prologue has to run before its next run (see peephole.hpp)
+    bool prologue_pending {true};
+    // Native code for the JIT engine
+    // 'jit_unavailable' is set when compiling failed (e.g., user-registered operators)
+    std::shared_ptr<JitCode const> jit_code;
+    bool jit_unavailable {false};
+
+    // From the last incremental batch run, or inherited from the parent (see BatchSnapshot)
+    std::shared_ptr<BatchSnapshot<T> const> snapshot;
+
+    // Computed on first use, dropped whenever the instructions change
+    mutable std::optional<std::uint64_t> canonical_hash;
+
+public:
+    LinearProgram(size_t rc=REGISTER_COUNT, size_t pl=PROGRAM_LENGTH) : Base(rc, pl) {
+        if (R > 0 && register_count > R) throw std::runtime_error("Too many registers for this program.");
+        if (L > 0 && program_length > L) throw std::runtime_error("Program too long for this program.");
+        registers = InlineStorage<T, R>(register_count, N::Zero());
+        InitProgram();
+    }
+
+    // Necessary for polymorphism
+    std::unique_ptr<Program> Clone() const override {
+        return std::make_unique<LinearProgram>(*this);
+    }
+
+    // Overwriting keeps this program's storage, so once it has room for the longest code
+    // (reserved here, the other program's code may be shorter) this never allocates
+    void Assign(Program const & other) override {
+        assert(typeid(other) == typeid(LinearProgram) && "Programs must be of the same class.");
+        if (&other == this) return;
+        LinearProgram const & source {static_cast<LinearProgram const &>(other)};
+        effective_instructions.reserve(source.instructions.size());
+        threaded_code.Reserve(source.instructions.size());
+        *this = source;
+    }
+
+    std::unique_ptr<Program> New() const override {
+        std::unique_ptr<Program> p {std::make_unique<LinearProgram>(register_count, program_length)};
+        p->InitProgram(); // just in case
+        return p;
+    }
+
+    void InitProgram() override {
+        instructions.clear(); // just in case
+        ResetRegisters();
+        snapshot.reset();
+
+        instructions.resize(program_length);
+
+        std::uniform_real_distribution<double> prob_dist(0.0, 1.0);
+        std::uniform_int_distribution<size_t> reg_dist(0, register_count - 1);
+        bool const ternary {layout.ternary && GLOBAL_OPERATORS.TernarySize() > 0};
+
+        for (Instruction & instr : instructions) {
+            instr.Ri = reg_dist(rng);
+            instr.Rj = reg_dist(rng);
+
+            // UNARY/BINARY OPERATOR
+            if (!ternary || prob_dist(rng) < 0.5) {
+                instr.op = GLOBAL_OPERATORS.GetRandomOpID();
+                instr.op_type = 0;
+            }
+            // TERNARY OPERATOR
+            else {
+                instr.op = GLOBAL_OPERATORS.GetRandomTernaryOpID();
+                instr.op_type = 1;
+                instr.Rt = reg_dist(rng);
+            }
+
+            // r[k]: Register or Constant?
+            if (prob_dist(rng) < rk_prob) {
+                if (GLOBAL_CONSTANTS.Size() > 0) {
+                    instr.Rk_type = RkType::CONSTANT;
+                    instr.Rk = GLOBAL_CONSTANTS.GetRandomConstantID();
+                }
+                else { // Fall back to REGISTER INDEX if no constants available
+                    instr.Rk_type = RkType::REGISTER;
+                    instr.Rk = reg_dist(rng);
+                }
+            }
+            else { // REGISTER INDEX
+                instr.Rk_type = RkType::REGISTER;
+                instr.Rk = reg_dist(rng);
+            }
+        }
+        UpdateEffectiveInstructions();
+    }
+
+    emp::vector<Instruction> GetInstructions() const override {
+        return emp::vector<Instruction>(instructions.begin(), instructions.end());
+    }
+    void SetInstructions(emp::vector<Instruction> const & in) override {
+        if (L > 0 && in.size() > L) throw std::runtime_error("Too many instructions for this program.");
+        this->ValidateInstructions(in);
+        instructions.assign(in.begin(), in.end());
+        UpdateEffectiveInstructions();
+    }
+
+    std::span<Instruction const> ViewInstructions() const override { return {instructions.data(), instructions.size()}; }
+    std::span<Instruction> EditInstructions() override { return {instructions.data(), instructions.size()}; }
+    void CommitInstructions() override {
+        this->ValidateInstructions(ViewInstructions());
+        UpdateEffectiveInstructions();
+    }
+
+    void UpdateEffectiveInstructions() {
+        this->FindEffectiveInstructions(ViewInstructions(), effective_mask);
+        effective_instructions.clear();
+        effective_instructions.reserve(instructions.size()); // so that reusing this program never reallocates
+        for (size_t i {0}; i < instructions.size(); ++i) {
+            if (effective_mask[i]) effective_instructions.push_back(instructions[i]);
+        }
+        threaded_compiled = false; // recompiled on next ExecuteProgram()
+        jit_code.reset();
+        jit_unavailable = false;
+        canonical_hash.reset();
+    }
+
+    std::span<Instruction const> GetEffectiveInstructions() const override { return effective_instructions; }
+    bool IsEffectiveInstruction(size_t i) const override { return i < effective_mask.size() && effective_mask[i]; }
+
+    // Hash of the optimized effective code (see HashOptimizedCode()), which is what every engine
+    // computes. Constants are folded in T, and the register type goes in too, since float or
+    // Fixed registers round differently
+    std::uint64_t CanonicalHash() const override {
+        if (!canonical_hash) canonical_hash = HashOptimizedCode(Optimize(), layout, TypeTag());
+        return *canonical_hash;
+    }
+
+    static constexpr std::uint64_t TypeTag() { return sizeof(T) * 2 + std::is_floating_point_v<T>; }
+
+    // The optimized effective code, in a buffer of this thread's that the next call overwrites
+    OptimizedCode const & Optimize() const {
+        static thread_local OptimizedCode optimized;
+        optimized.code.reserve(instructions.size()); // optimized code is never longer than the program
+        OptimizeProgram<T>(effective_instructions, layout, register_count, optimized);
+        return optimized;
+    }
+
+    T GetRkValue(Instruction const & instr) const {
+        if (instr.Rk_type == RkType::CONSTANT) return N::FromDouble(GLOBAL_CONSTANTS.GetConstant(instr.Rk));
+        return registers[instr.Rk];
+    }
+
+    void ExecuteInstruction(Instruction const & instr) final {
+        // Instructions are represented as r[i] = op (r[j] r[k])
+        // OR r[i] = op (r[j] r[t] r[k]) if TERNARY
+        T Rk_value {GetRkValue(instr)};
+
+        if (instr.op_type == 0) {
+            // Registers are clamped to avoid under/overflow
+            registers[instr.Ri] = N::Clamp(GLOBAL_OPERATORS.Apply(instr.op, registers[instr.Rj], Rk_value));
+        }
+        else { // IF TERNARY
+            // Operands were validated in SetInstructions()
+            registers[instr.Ri] = N::Clamp(GLOBAL_OPERATORS.ApplyTernary(
+                instr.op, registers[instr.Rj], registers[instr.Rt], Rk_value));
+        }
+    }
+
+    // This returns the RAW output
+    // Structural introns are skipped, so registers that don't feed the output may hold
+    // different values than a full run would leave in them
+    double ExecuteProgram() override {
+        if (!RunCompiled()) {
+            for (Instruction const & instr : effective_instructions) {
+                ExecuteInstruction(instr);
+            }
+        }
+        return N::ToDouble(N::Clamp(registers[layout.output]));
+    }
+
+    // Runs the effective code with the THREADED or JIT engine
+    // Returns false if it has to be interpreted instead
+    bool RunCompiled() {
+        if constexpr (std::is_same_v<T, double>) {
+            if (engine == ExecutionEngine::THREADED) {
+                if (!threaded_compiled) CompileThreaded();
+                if (prologue_pending) {
+                    threaded_code.RunPrologue(registers.data());
+                    prologue_pending = false;
+                }
+                threaded_code.Run(registers.data());
+                return true;
+            }
+            if (engine == ExecutionEngine::JIT && CompileJit()) {
+                jit_code->Run(registers.data());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Vectorized version of ResetRegisters() + Input() + ExecuteProgram() for every input
+    // Registers are laid out as [register][case], so each instruction runs once over all cases
+    // This does not touch 'registers'
+    // Only for single-input layouts that reset registers between runs; others run one by one
+    using Program::ExecuteProgramBatch;
+    void ExecuteProgramBatch(double const * inputs, size_t n, double * outputs) override {
+        if (layout.carry_registers || layout.input_count != 1) {
+            Base::ExecuteProgramBatch(inputs, n, outputs);
+            return;
+        }
+
+        // Reused across calls (and not copied by Clone())
+        static thread_local emp::vector<T> batch_registers;
+        static thread_local emp::vector<T> scratch;
+        batch_registers.assign(register_count * n, N::Zero());
+        scratch.resize(n);
+
+        T * input_row {batch_registers.data() + layout.input_begin * n};
+        for (size_t c {0}; c < n; ++c) input_row[c] = N::FromDouble(inputs[c]);
+        for (Instruction const & instr : effective_instructions) {
+            ExecuteInstructionBatch(instr, batch_registers.data(), n, scratch.data());
+        }
+
+        T const * output_row {batch_registers.data() + layout.output * n};
+        for (size_t c {0}; c < n; ++c) outputs[c] = N::ToDouble(N::Clamp(output_row[c]));
+    }
+
+    // Same results as ExecuteProgramBatch(), but the registers that are still needed are saved
+    // every few instructions (at most 'snapshot_bytes' worth of them), and the run restarts from
+    // the latest saved state of this program's snapshot (usually its parent's) that is within the
+    // prefix the current effective instructions share with it and that holds every register they
+    // need from there on. When a mutation lands late in the program, most of it is skipped.
+    // Snapshots are only used with the same 'inputs' (same pointer and size) they were made for.
+    void ExecuteProgramBatchIncremental(double const * inputs, size_t n, double * outputs,
+        size_t snapshot_bytes) override {
+        if (layout.carry_registers || layout.input_count != 1) {
+            Base::ExecuteProgramBatch(inputs, n, outputs);
+            return;
+        }
+        using Registers = std::bitset<MAX_REGISTER_COUNT>;
+
+        static thread_local emp::vector<T> batch_registers;
+        static thread_local emp::vector<T> scratch;
+        batch_registers.assign(register_count * n, N::Zero());
+        scratch.resize(n);
+        T * input_row {batch_registers.data() + layout.input_begin * n};
+        for (size_t c {0}; c < n; ++c) input_row[c] = N::FromDouble(inputs[c]);
+
+        auto next {std::make_shared<BatchSnapshot<T>>()};
+        next->inputs = inputs;
+        next->case_count = n;
+        next->code.assign(effective_instructions.begin(), effective_instructions.end());
+        size_t const len {next->code.size()};
+
+        // needed[i]: registers that code[i, len) reads before writing them
+        static thread_local emp::vector<Registers> needed;
+        needed.assign(len + 1, Registers{});
+        needed[len].set(layout.output);
+        for (size_t i {len}; i-- > 0; ) {
+            Instruction const & instr {next->code[i]};
+            needed[i] = needed[i + 1];
+            needed[i].reset(instr.Ri);
+            needed[i].set(instr.Rj);
+            if (instr.op_type == 1) needed[i].set(instr.Rt);
+            if (instr.Rk_type == RkType::REGISTER) needed[i].set(instr.Rk);
+        }
+        // written[i]: registers that code[0, i) writes
+        static thread_local emp::vector<Registers> written;
+        written.assign(len + 1, Registers{});
+        for (size_t i {0}; i < len; ++i) {
+            written[i + 1] = written[i];
+            written[i + 1].set(next->code[i].Ri);
+        }
+
+        // Restart from the latest usable parent state within the shared prefix
+        size_t start {0};
+        size_t used_bytes {0};
+        if (snapshot && snapshot->inputs == inputs && snapshot->case_count == n) {
+            size_t const shared {static_cast<size_t>(std::mismatch(
+                next->code.begin(), next->code.end(), snapshot->code.begin(), snapshot->code.end()).first
+                - next->code.begin())};
+            size_t restore {0}; // 1 + index of the state to restore
+            for (size_t s {0}; s < snapshot->positions.size() && snapshot->positions[s] <= shared; ++s) {
+                size_t const pos {snapshot->positions[s]};
+                // Same prefix, so anything this program needs was saved, unless the parent didn't need it
+                if (((needed[pos] & written[pos]) & ~snapshot->saved[s]).none()) restore = s + 1;
+            }
+            // Keep the parent's states up to there, they hold for this program too
+            for (size_t s {0}; s < restore; ++s) {
+                next->positions.push_back(snapshot->positions[s]);
+                next->saved.push_back(snapshot->saved[s]);
+                next->states.push_back(snapshot->states[s]);
+                used_bytes += snapshot->states[s]->size() * sizeof(T);
+            }
+            if (restore > 0) {
+                start = next->positions.back();
+                T const * row {next->states.back()->data()};
+                for (size_t r {0}; r < register_count; ++r) {
+                    if (!next->saved.back().test(r)) continue;
+                    std::copy(row, row + n, batch_registers.begin() + r * n);
+                    row += n;
+                }
+            }
+        }
+
+        // Save every 'stride' instructions; the stride only depends on the program length, so
+        // parents and children save at the same places. Saving a row costs about as much as
+        // running an instruction, so only save a few times per program
+        size_t const stride {std::max<size_t>(4, program_length / 4)};
+        for (size_t i {start}; i < len; ++i) {
+            Registers const save {needed[i] & written[i]};
+            size_t const bytes {save.count() * n * sizeof(T)};
+            if (i > start && i % stride == 0 && used_bytes + bytes <= snapshot_bytes) {
+                auto state {std::make_shared<emp::vector<T>>()};
+                state->reserve(save.count() * n);
+                for (size_t r {0}; r < register_count; ++r) {
+                    if (save.test(r)) state->insert(state->end(), batch_registers.begin() + r * n, batch_registers.begin() + (r + 1) * n);
+                }
+                next->positions.push_back(i);
+                next->saved.push_back(save);
+                next->states.push_back(std::move(state));
+                used_bytes += bytes;
+            }
+            ExecuteInstructionBatch(next->code[i], batch_registers.data(), n, scratch.data());
+        }
+
+        T const * output_row {batch_registers.data() + layout.output * n};
+        for (size_t c {0}; c < n; ++c) outputs[c] = N::ToDouble(N::Clamp(output_row[c]));
+        snapshot = std::move(next);
+    }
+
+    // Runs the group as a trie of effective code: programs are sorted by their effective
+    // instructions, so each one only differs from the previous one after their common prefix.
+    // The register file is saved at the prefix lengths later programs restart from, and each
+    // program only runs its instructions past that. Same outputs as ExecuteProgramBatch()
+    // Falls back to running them one by one unless every program is a LinearProgram of this
+    // exact type and register count
+    SharedBatchStats ExecuteGroupBatch(std::span<Program * const> group, double const * inputs,
+        size_t n, double * outputs) const override {
+        emp::vector<LinearProgram const *> progs;
+        for (Program * p : group) {
+            auto const * lp {dynamic_cast<LinearProgram const *>(p)};
+            if (!lp || lp->register_count != register_count) break;
+            progs.push_back(lp);
+        }
+        if (progs.size() != group.size() || layout.carry_registers || layout.input_count != 1) {
+            return Base::ExecuteGroupBatch(group, inputs, n, outputs);
+        }
+
+        auto code = [&](size_t g) { return std::span<Instruction const>(progs[g]->effective_instructions); };
+        auto instr_less = [](Instruction const & a, Instruction const & b) {
+            return std::bit_cast<std::uint64_t>(a) < std::bit_cast<std::uint64_t>(b);
+        };
+        emp::vector<size_t> order(progs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return std::lexicographical_compare(code(a).begin(), code(a).end(), code(b).begin(), code(b).end(), instr_less);
+        });
+        // shared[k]: length of the prefix order[k] and order[k + 1] have in common
+        emp::vector<size_t> shared(order.size() > 0 ? order.size() - 1 : 0);
+        for (size_t k {0}; k < shared.size(); ++k) {
+            std::span<Instruction const> const a {code(order[k])}, b {code(order[k + 1])};
+            shared[k] = static_cast<size_t>(std::mismatch(a.begin(), a.end(), b.begin(), b.end()).first - a.begin());
+        }
+
+        // Reused across calls; saved states form a stack, deepest on top
+        static thread_local emp::vector<T> batch_registers;
+        static thread_local emp::vector<T> scratch;
+        static thread_local emp::vector<emp::vector<T>> states;
+        emp::vector<size_t> depths; // prefix length of each saved state
+        batch_registers.assign(register_count * n, N::Zero());
+        scratch.resize(n);
+        T * input_row {batch_registers.data() + layout.input_begin * n};
+        for (size_t c {0}; c < n; ++c) input_row[c] = N::FromDouble(inputs[c]);
+        auto save = [&](size_t depth) {
+            if (states.size() <= depths.size()) states.emplace_back();
+            states[depths.size()].assign(batch_registers.begin(), batch_registers.end());
+            depths.push_back(depth);
+        };
+        save(0);
+
+        SharedBatchStats stats;
+        size_t depth {0}; // prefix of the previous program that 'batch_registers' holds
+        emp::vector<size_t> save_at;
+        for (size_t k {0}; k < order.size(); ++k) {
+            std::span<Instruction const> const instrs {code(order[k])};
+            size_t const start {k == 0 ? 0 : shared[k - 1]};
+            while (depths.back() > start) depths.pop_back();
+            if (depth != start) {
+                assert(depths.back() == start);
+                std::copy(states[depths.size() - 1].begin(), states[depths.size() - 1].end(), batch_registers.begin());
+            }
+
+            // Later programs restart at the running minimum of the shared lengths; the ones
+            // deeper than 'start' go through this program only
+            save_at.clear();
+            size_t low {instrs.size() + 1};
+            for (size_t j {k}; j < shared.size() && low > start; ++j) {
+                if (shared[j] < low && shared[j] > start) save_at.push_back(shared[j]);
+                low = std::min(low, shared[j]);
+            }
+
+            for (size_t i {start}; i <= instrs.size(); ++i) {
+                if (!save_at.empty() && save_at.back() == i) {
+                    save(i);
+                    save_at.pop_back();
+                }
+                if (i < instrs.size()) ExecuteInstructionBatch(instrs[i], batch_registers.data(), n, scratch.data());
+            }
+            depth = instrs.size();
+            stats.executed += instrs.size() - start;
+            stats.naive += instrs.size();
+
+            T const * output_row {batch_registers.data() + layout.output * n};
+            double * out {outputs + order[k] * n};
+            for (size_t c {0}; c < n; ++c) out[c] = N::ToDouble(N::Clamp(output_row[c]));
+        }
+        return stats;
+    }
+
+    void Input(double in) override {
+        if (layout.input_count != 1) {
+            assert(false && "Single input is not an option for this program.");
+            return;
+        }
+        registers[layout.input_begin] = N::FromDouble(in);
+    }
+
+    void Input(emp::vector<double> const & inputs) override {
+        assert(inputs.size() >= layout.input_count && "Not enough inputs.");
+        for (size_t i {0}; i < layout.input_count; ++i) {
+            registers[layout.input_begin + i] = N::FromDouble(inputs[i]);
+        }
+    }
+
+    // This returns the RAW output
+    double GetOutput() const override {
+        return N::ToDouble(registers[layout.output]);
+    }
+
+    double GetRegister(size_t r) const override { return N::ToDouble(registers[r]); }
+
+    void ResetRegisters() override {
+        for (T & reg : registers) {
+            reg = N::Zero();
+        }
+        prologue_pending = true;
+    }
+
+    emp::vector<double> GetRegisters() const override {
+        emp::vector<double> values;
+        for (T reg : registers) values.push_back(N::ToDouble(reg));
+        return values;
+    }
+
+    void CompileThreaded() {
+        OptimizedCode const & optimized {Optimize()};
+        threaded_code.Reserve(instructions.size()); // like effective_instructions
+        threaded_code.Compile(optimized);
+        threaded_compiled = true;
+        prologue_pending = true;
+        // The hash comes from the same optimized code, so it is free here
+        if (!canonical_hash) canonical_hash = HashOptimizedCode(optimized, layout, TypeTag());
+    }
+
+    // Compiles the effective instructions to native code if it hasn't been tried yet
+    // Returns false if the program has to be interpreted instead
+    bool CompileJit() {
+        if (!jit_code && !jit_unavailable) {
+            jit_code = JitCode::Compile(effective_instructions);
+            jit_unavailable = !jit_code;
+            assert((!jit_code || jit_code->Verify(effective_instructions, registers.size()))
+                && "JIT code does not match the interpreter.");
+        }
+        return jit_code != nullptr;
+    }
+
+    // Only double registers can use the THREADED and JIT engines
+    ExecutionEngine GetExecutionEngine() const { return engine; }
+    void SetExecutionEngine(ExecutionEngine e) { engine = e; }
+};
+
+#endif
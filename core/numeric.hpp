@@ -0,0 +1,85 @@
+#ifndef NUMERIC_HPP
+#define NUMERIC_HPP
+
+// Register value types.
+// Programs are templated on the type their registers hold (see LinearProgram);
+// NumericTraits<T> defines how that type is clamped, converted to/from the
+// double-based parts of the library (constants, inputs, fitness, user-registered operators)
+// and how the protected operators behave.
+//  - double: the original behavior
+//  - float: half the register memory, twice the SIMD width in batch execution
+//  - Fixed: saturating fixed-point integers, for domains with small integer/boolean inputs (mazes)
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+template <typename T, typename = void>
+struct NumericTraits;
+
+// double and float
+template <typename T>
+struct NumericTraits<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+    static constexpr T lo {static_cast<T>(-1e6)}, hi {static_cast<T>(1e6)};
+
+    static T Zero() { return T{0}; }
+    static T FromBool(bool b) { return static_cast<T>(b); }
+    static bool AsBool(T v) { return v > T{0}; } // see Operators::AsBool()
+    static T FromDouble(double v) { return static_cast<T>(v); }
+    static double ToDouble(T v) { return static_cast<double>(v); }
+
+    // Same as std::clamp(v, lo, hi), NaN included, but written as two selects so it vectorizes
+    static T Clamp(T v) {
+        v = (v < lo) ? lo : v;
+        return (hi < v) ? hi : v;
+    }
+
+    static T Add(T a, T b) { return a + b; }
+    static T Sub(T a, T b) { return a - b; }
+    static T Mult(T a, T b) { return a * b; }
+    static T Div(T a, T b) { return (b != 0) ? a / b : T{1}; } // protected
+};
+
+// Fixed-point number with FRAC_BITS fractional bits, stored in an int32
+// Every operation saturates to [-1e6, 1e6], so values never need clamping and there's no NaN/inf
+struct Fixed {
+    static constexpr int FRAC_BITS {10};
+    static constexpr std::int32_t ONE {1 << FRAC_BITS};
+    static constexpr std::int32_t MAX_RAW {1000000 * ONE}; // 1e6, still fits in an int32
+
+    std::int32_t raw {0};
+
+    friend bool operator==(Fixed, Fixed) = default;
+};
+
+template <>
+struct NumericTraits<Fixed> {
+    static Fixed Saturate(std::int64_t raw) {
+        return Fixed{static_cast<std::int32_t>(std::clamp<std::int64_t>(raw, -Fixed::MAX_RAW, Fixed::MAX_RAW))};
+    }
+
+    static Fixed Zero() { return Fixed{0}; }
+    static Fixed FromBool(bool b) { return Fixed{b ? Fixed::ONE : 0}; }
+    static bool AsBool(Fixed v) { return v.raw > 0; }
+
+    // Rounds to the nearest step; NaN becomes 0
+    static Fixed FromDouble(double v) {
+        if (std::isnan(v)) return Fixed{0};
+        v = std::clamp(v, -1e6, 1e6);
+        return Saturate(std::llround(v * Fixed::ONE));
+    }
+    static double ToDouble(Fixed v) { return static_cast<double>(v.raw) / Fixed::ONE; }
+
+    static Fixed Clamp(Fixed v) { return v; } // already saturated
+
+    static Fixed Add(Fixed a, Fixed b) { return Saturate(std::int64_t{a.raw} + b.raw); }
+    static Fixed Sub(Fixed a, Fixed b) { return Saturate(std::int64_t{a.raw} - b.raw); }
+    static Fixed Mult(Fixed a, Fixed b) { return Saturate((std::int64_t{a.raw} * b.raw) >> Fixed::FRAC_BITS); }
+    static Fixed Div(Fixed a, Fixed b) { // protected
+        if (b.raw == 0) return Fixed{Fixed::ONE};
+        return Saturate((std::int64_t{a.raw} * Fixed::ONE) / b.raw);
+    }
+};
+
+#endif
@@ -8,28 +8,46 @@
 
 #include "emp/base/vector.hpp"
 
+#include "numeric.hpp"
+#include "random.hpp"
+
+// Opcodes for the default operators, so programs can run them through a switch
+// instead of going through std::function. User-registered operators are CUSTOM.
+enum class OpCode : unsigned char {
+    ADD, SUB, MULT, DIV,
+    AND, OR, NAND, NOR, XOR,
+    GREATER, EQUAL, LESS, IF, NOT,
+    IF3, // ternary
+    CUSTOM
+};
+
 class Operators {
 private:
     // Unless ternary is set, all operators take two parameters for syntax consistency.
     // For unary operators, we ignore the second argument. 
     using operator_func = std::function<double(double, double)>;
     std::vector<std::pair<std::string, operator_func>> operators;
+    std::vector<OpCode> opcodes; // opcodes[id] = opcode of operators[id]
     
     // Ternary is set to false by default
     using ternary_operator_func = std::function<double(double, double, double)>;
     emp::vector<std::pair<std::string, ternary_operator_func>> ternary_operators;
+    emp::vector<OpCode> ternary_opcodes;
 
     std::mt19937 mutable rng;
 
     bool ternary;
 
 public:
-    Operators(bool tern=false) : rng(SEED), ternary(tern) { 
+    // Without 'arith', only the logic operators are registered (e.g., for BooleanEvaluator)
+    Operators(bool tern=false, bool arith=true) : rng(SEED), ternary(tern) { 
         // Default operators
-        RegisterOperator("ADD", [](double a, double b) { return a + b; });
-        RegisterOperator("SUB", [](double a, double b) { return a - b; });
-        RegisterOperator("MULT", [](double a, double b) { return a * b; });
-        RegisterOperator("DIV", [](double a, double b) { return (b != 0) ? a / b : 1.0; }); // protected
+        if (arith) {
+            RegisterBuiltinOperator("ADD", OpCode::ADD);
+            RegisterBuiltinOperator("SUB", OpCode::SUB);
+            RegisterBuiltinOperator("MULT", OpCode::MULT);
+            RegisterBuiltinOperator("DIV", OpCode::DIV); // protected
+        }
 
         RegisterLogicOperators();
         
@@ -40,6 +58,7 @@ public:
 
     void RegisterOperator(std::string const & name, operator_func func) {
         operators.emplace_back(name, func);
+        opcodes.push_back(OpCode::CUSTOM);
     }
 
     void RegisterUnaryOperator(std::string const & name, std::function<double(double)> func) {
@@ -50,6 +69,21 @@ public:
 
     void RegisterTernaryOperator(std::string const & name, ternary_operator_func func) {
         ternary_operators.emplace_back(name, func);
+        ternary_opcodes.push_back(OpCode::CUSTOM);
+    }
+
+    // Default operators keep a std::function (for GetOperator()) that routes back to
+    // ApplyBuiltin(), so the switch is the only definition of their behavior
+    void RegisterBuiltinOperator(std::string const & name, OpCode code) {
+        operators.emplace_back(name, [code](double a, double b) { return ApplyBuiltin(code, a, b); });
+        opcodes.push_back(code);
+    }
+
+    void RegisterBuiltinTernaryOperator(std::string const & name, OpCode code) {
+        ternary_operators.emplace_back(name, [code](double cond, double a, double b) {
+            return ApplyBuiltinTernary(code, cond, a, b);
+        });
+        ternary_opcodes.push_back(code);
     }
     
 
@@ -64,49 +98,113 @@ public:
 
     // Bundle a set of default logic operators
     void RegisterLogicOperators() {
-        RegisterOperator("AND", [](double a, double b) { return AsBool(a) && AsBool(b); });
-        RegisterOperator("OR", [](double a, double b) { return AsBool(a) || AsBool(b); });
-        RegisterOperator("NAND", [](double a, double b) { return !(AsBool(a) && AsBool(b)); });
-        RegisterOperator("NOR", [](double a, double b) { return !(AsBool(a) || AsBool(b)); });
-        RegisterOperator("XOR", [](double a, double b) { return AsBool(a) != AsBool(b); });
+        RegisterBuiltinOperator("AND", OpCode::AND);
+        RegisterBuiltinOperator("OR", OpCode::OR);
+        RegisterBuiltinOperator("NAND", OpCode::NAND);
+        RegisterBuiltinOperator("NOR", OpCode::NOR);
+        RegisterBuiltinOperator("XOR", OpCode::XOR);
 
-        RegisterOperator("GREATER", [](double a, double b) { return AsBool(a) > AsBool(b); });
-        RegisterOperator("EQUAL", [](double a, double b) { return AsBool(a) == AsBool(b); });
-        RegisterOperator("LESS", [](double a, double b) { return AsBool(a) < AsBool(b); });
+        RegisterBuiltinOperator("GREATER", OpCode::GREATER);
+        RegisterBuiltinOperator("EQUAL", OpCode::EQUAL);
+        RegisterBuiltinOperator("LESS", OpCode::LESS);
 
         // Let b pass if a is true (if a, then b)
-        RegisterOperator("IF", [](double a, double b) {
-            return AsBool(a)? b : 0.0;
-        });
+        RegisterBuiltinOperator("IF", OpCode::IF);
 
-        RegisterUnaryOperator("NOT", [](double a) { return !AsBool(a); });
+        RegisterBuiltinOperator("NOT", OpCode::NOT); // unary, b is ignored
     }
 
     // Bundle a set of default ternary operators
     void RegisterTernaryOperators() {
-        RegisterTernaryOperator("IF-3", [](double cond, double a, double b) {
-            return AsBool(cond)? a : b;
-        }); 
+        RegisterBuiltinTernaryOperator("IF-3", OpCode::IF3);
+    }
+
+    // Semantics of the default operators, for any register type (see numeric.hpp)
+    // Results are not clamped
+    template <typename T>
+    static T ApplyBuiltin(OpCode code, T a, T b) {
+        using N = NumericTraits<T>;
+        switch (code) {
+            case OpCode::ADD: return N::Add(a, b);
+            case OpCode::SUB: return N::Sub(a, b);
+            case OpCode::MULT: return N::Mult(a, b);
+            case OpCode::DIV: return N::Div(a, b); // protected
+            case OpCode::AND: return N::FromBool(N::AsBool(a) && N::AsBool(b));
+            case OpCode::OR: return N::FromBool(N::AsBool(a) || N::AsBool(b));
+            case OpCode::NAND: return N::FromBool(!(N::AsBool(a) && N::AsBool(b)));
+            case OpCode::NOR: return N::FromBool(!(N::AsBool(a) || N::AsBool(b)));
+            case OpCode::XOR: return N::FromBool(N::AsBool(a) != N::AsBool(b));
+            case OpCode::GREATER: return N::FromBool(N::AsBool(a) > N::AsBool(b));
+            case OpCode::EQUAL: return N::FromBool(N::AsBool(a) == N::AsBool(b));
+            case OpCode::LESS: return N::FromBool(N::AsBool(a) < N::AsBool(b));
+            case OpCode::IF: return N::AsBool(a) ? b : N::Zero();
+            case OpCode::NOT: return N::FromBool(!N::AsBool(a));
+            default:
+                assert(false && "Not a built-in unary/binary operator.");
+                return N::Zero();
+        }
+    }
+
+    template <typename T>
+    static T ApplyBuiltinTernary(OpCode code, T cond, T a, T b) {
+        assert(code == OpCode::IF3 && "Not a built-in ternary operator.");
+        (void) code;
+        return NumericTraits<T>::AsBool(cond) ? a : b;
+    }
+
+    // Fast path used by the interpreters: built-in operators are dispatched through
+    // the switch above, user-registered ones fall back to their std::function
+    // (which works on doubles, so other register types are converted back and forth)
+    template <typename T>
+    T Apply(size_t id, T a, T b) const {
+        assert(id < operators.size() && "Invalid operator ID.");
+        using N = NumericTraits<T>;
+        OpCode code {opcodes[id]};
+        if (code != OpCode::CUSTOM) return ApplyBuiltin(code, a, b);
+        return N::FromDouble(operators[id].second(N::ToDouble(a), N::ToDouble(b)));
+    }
+
+    template <typename T>
+    T ApplyTernary(size_t id, T cond, T a, T b) const {
+        assert(id < ternary_operators.size() && "Invalid ternary operator ID.");
+        using N = NumericTraits<T>;
+        OpCode code {ternary_opcodes[id]};
+        if (code != OpCode::CUSTOM) return ApplyBuiltinTernary(code, cond, a, b);
+        return N::FromDouble(ternary_operators[id].second(N::ToDouble(cond), N::ToDouble(a), N::ToDouble(b)));
+    }
+
+    OpCode GetOpCode(size_t id) const {
+        assert(id < opcodes.size() && "Invalid operator ID.");
+        return opcodes[id];
+    }
+
+    OpCode GetTernaryOpCode(size_t id) const {
+        assert(id < ternary_opcodes.size() && "Invalid ternary operator ID.");
+        return ternary_opcodes[id];
     }
     
     size_t Size() const {
         return operators.size();
     }
 
+    size_t TernarySize() const {
+        return ternary_operators.size();
+    }
+
     size_t GetRandomOpID() const {
         // Selects a random operator from the set
         assert(!operators.empty() && "No operators available.");
         std::uniform_int_distribution<size_t> dist(0, operators.size() - 1);
-        return dist(rng);
+        return dist(ReplicateStream::Or(rng));
     }
 
     size_t GetRandomTernaryOpID() const {
         assert(!ternary_operators.empty() && "No ternary operators available.");
         std::uniform_int_distribution<size_t> dist(0, ternary_operators.size() - 1);
-        return dist(rng);
+        return dist(ReplicateStream::Or(rng));
     }
 
-    operator_func GetOperator(size_t id) const {
+    operator_func const & GetOperator(size_t id) const {
         assert(id < operators.size() && "Invalid operator ID.");
         return operators[id].second;
     }
@@ -147,7 +245,7 @@ public:
         return false;
     }
 
-    ternary_operator_func GetTernaryOperator(size_t id) const {
+    ternary_operator_func const & GetTernaryOperator(size_t id) const {
         assert(id < ternary_operators.size() && "Invalid ternary operator ID.");
         return ternary_operators[id].second;
     }
@@ -183,4 +281,4 @@ public:
     }
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,312 @@
+#ifndef PEEPHOLE_HPP
+#define PEEPHOLE_HPP
+
+// Rewrites a program's effective instructions into a shorter execution form, without touching
+// the genome (the variators keep working on the original instructions). Runs in four passes:
+//  1. Constant folding and peephole rewrites, going forwards. Register values are tracked where
+//     they are known (registers start at 0 in layouts that reset them, constants are known), and:
+//      - instructions whose operands are all known become LOADs of the result
+//      - ADD/SUB x 0, MULT x 1 (either side), DIV x 1 become MOVEs
+//      - IF/IF-3 with a known condition become a MOVE or LOAD of the selected operand
+//      - AND/NAND/GREATER with a known false operand, OR/NOR/LESS with a known true one become LOADs
+//     User-registered operators are never folded (they may not be pure).
+//     Folding computes in the register type T (see numeric.hpp), so float and Fixed programs fold
+//     to what they would compute at run time, and CanonicalHash() only matches programs that do.
+//  2. Dead store elimination with kills, going backwards: unlike FindEffectiveInstructions(),
+//     a write that is overwritten before it is read is removed (this also cleans up the writes
+//     that pass 1 made unnecessary).
+//  3. Register remapping: the registers that are still used get the lowest free indices, so the
+//     code touches a dense block of the register file. Inputs and output keep their registers.
+//     The mapping is a permutation, so registers carried over between runs stay consistent.
+//  4. Hoisting: instructions that compute the same value on every run (e.g., every step of a maze
+//     simulation) are moved to the front, into a prologue that only has to run again after the
+//     registers are reset (see LinearProgram::RunCompiled()). An instruction is hoisted if its
+//     operands are constants, registers nothing writes, or registers written by hoisted
+//     instructions, and its destination is written by nothing else and not read before it
+//     (so the first run, which starts from reset registers, can't tell the difference).
+//     Only the THREADED engine runs the prologue separately; the JIT compiles the unoptimized
+//     effective instructions, so nothing is hoisted out of its runs.
+// Only the sign of a zero can differ from the original code (x + 0 gives +0 for x = -0), and
+// no built-in operator can tell the two apart.
+
+#include <bit>
+#include <span>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <optional>
+#include <algorithm>
+
+#include "emp/base/vector.hpp"
+
+#include "instructions.hpp"
+#include "operators.hpp"
+#include "numeric.hpp"
+#include "base_prog.hpp"
+
+struct ExecInstruction {
+    enum class Kind : std::uint8_t {
+        OP, // 'instr' as usual, with a constant r[k] stored by value in 'k'
+        MOVE, // r[i] = r[j] (clamped, since inputs aren't)
+        LOAD // r[i] = k
+    };
+
+    Kind kind {Kind::OP};
+    Instruction instr;
+    double k {0.0};
+};
+
+struct OptimizedCode {
+    emp::vector<ExecInstruction> code;
+    size_t prologue_size {0}; // code[0, prologue_size) is the hoisted prologue
+};
+
+// 'instrs' must be validated (see LinearProgramBase::ValidateInstructions())
+// Writes into 'result', reusing its storage; per-register state lives on the stack and the
+// per-instruction buffers are reused across calls, so this doesn't allocate once they are big enough
+// T is the register type; LOADs hold the folded T value converted to double
+template <typename T=double>
+void OptimizeProgram(std::span<Instruction const> instrs,
+    RegisterLayout const & layout, size_t register_count, OptimizedCode & result) {
+    using N = NumericTraits<T>;
+    using Kind = ExecInstruction::Kind;
+    using Registers = std::bitset<MAX_REGISTER_COUNT>;
+    auto is_input = [&](size_t r) { return layout.IsInput(r); };
+    size_t const output {layout.output};
+    bool const carry_registers {layout.carry_registers};
+
+    static thread_local emp::vector<ExecInstruction> code, optimized, body;
+    static thread_local emp::vector<bool> keep;
+
+    // ---- 1. CONSTANT FOLDING AND PEEPHOLE ----
+    T const zero {N::Zero()}, one {N::FromBool(true)};
+    std::array<std::optional<T>, MAX_REGISTER_COUNT> known {};
+    if (!carry_registers) {
+        for (size_t r {0}; r < register_count; ++r) if (!is_input(r)) known[r] = zero;
+    }
+
+    code.clear();
+    code.reserve(instrs.size());
+    for (Instruction const & instr : instrs) {
+        ExecInstruction e {Kind::OP, instr, 0.0};
+        bool const k_const {instr.Rk_type == RkType::CONSTANT};
+        if (k_const) e.k = GLOBAL_CONSTANTS.GetConstant(instr.Rk);
+
+        std::optional<T> const a {known[instr.Rj]};
+        std::optional<T> const b {k_const ? std::optional<T>{N::FromDouble(e.k)} : known[instr.Rk]};
+        std::optional<T> loaded;
+        auto load = [&](T v) {
+            e.kind = Kind::LOAD;
+            loaded = N::Clamp(v);
+            e.k = N::ToDouble(*loaded);
+        };
+        auto move_j = [&] { e.kind = Kind::MOVE; };
+        auto move_k = [&] { // r[k] may be a constant
+            if (b) load(*b);
+            else { e.kind = Kind::MOVE; e.instr.Rj = static_cast<std::uint8_t>(instr.Rk); }
+        };
+        auto move_t = [&] {
+            if (known[instr.Rt]) load(*known[instr.Rt]);
+            else { e.kind = Kind::MOVE; e.instr.Rj = instr.Rt; }
+        };
+        auto is_true = [](std::optional<T> v) { return v && N::AsBool(*v); };
+        auto is_false = [](std::optional<T> v) { return v && !N::AsBool(*v); };
+
+        if (instr.op_type == 1) {
+            OpCode const code_t {GLOBAL_OPERATORS.GetTernaryOpCode(instr.op)};
+            if (code_t == OpCode::IF3 && a) {
+                if (N::AsBool(*a)) move_t();
+                else move_k();
+            }
+        }
+        else {
+            OpCode const op {GLOBAL_OPERATORS.GetOpCode(instr.op)};
+            if (op == OpCode::CUSTOM) { }
+            else if (a && (b || op == OpCode::NOT)) load(Operators::ApplyBuiltin(op, *a, b.value_or(zero)));
+            else switch (op) {
+                case OpCode::ADD:
+                    if (b == zero) move_j();
+                    else if (a == zero) move_k();
+                    break;
+                case OpCode::SUB: case OpCode::DIV:
+                    if (b == (op == OpCode::SUB ? zero : one)) move_j();
+                    break;
+                case OpCode::MULT:
+                    if (b == one) move_j();
+                    else if (a == one) move_k();
+                    break;
+                case OpCode::IF:
+                    if (is_true(a)) move_k();
+                    else if (is_false(a)) load(zero);
+                    break;
+                case OpCode::AND: case OpCode::NAND:
+                    if (is_false(a) || is_false(b)) load(op == OpCode::AND ? zero : one);
+                    break;
+                case OpCode::OR: case OpCode::NOR:
+                    if (is_true(a) || is_true(b)) load(op == OpCode::OR ? one : zero);
+                    break;
+                case OpCode::GREATER: // a && !b
+                    if (is_false(a) || is_true(b)) load(zero);
+                    break;
+                case OpCode::LESS: // !a && b
+                    if (is_true(a) || is_false(b)) load(zero);
+                    break;
+                default: break;
+            }
+        }
+
+        if (e.kind == Kind::LOAD) known[instr.Ri] = loaded;
+        else if (e.kind == Kind::MOVE && known[e.instr.Rj]) known[instr.Ri] = N::Clamp(*known[e.instr.Rj]);
+        else known[instr.Ri].reset();
+        code.push_back(e);
+    }
+
+    // ---- 2. DEAD STORE ELIMINATION ----
+    // Marks what is live before each instruction, given what is live at the end
+    auto reads = [](ExecInstruction const & e, auto && use) {
+        if (e.kind == Kind::LOAD) return;
+        use(e.instr.Rj);
+        if (e.kind == Kind::MOVE) return;
+        if (e.instr.op_type == 1) use(e.instr.Rt);
+        if (e.instr.Rk_type == RkType::REGISTER) use(e.instr.Rk);
+    };
+    auto backwards = [&](Registers live) {
+        keep.assign(code.size(), false);
+        for (size_t i {code.size()}; i-- > 0; ) {
+            size_t const ri {code[i].instr.Ri};
+            if (!live[ri]) continue;
+            keep[i] = true;
+            live[ri] = false; // kill before gen: r = op(r, ...) keeps r live
+            reads(code[i], [&](size_t r) { live[r] = true; });
+        }
+        return live; // live at the start
+    };
+
+    Registers live_at_end;
+    live_at_end[output] = true;
+    // Registers read before they are written carry their value over from the previous run
+    // Repeat until the set of carried-over registers stops growing
+    while (true) {
+        Registers const live_at_start {backwards(live_at_end)};
+        if (!carry_registers) break;
+        bool changed {false};
+        for (size_t r {0}; r < register_count; ++r) {
+            if (live_at_start[r] && !live_at_end[r] && !is_input(r)) {
+                live_at_end[r] = true;
+                changed = true;
+            }
+        }
+        if (!changed) break;
+    }
+
+    optimized.clear();
+    for (size_t i {0}; i < code.size(); ++i) if (keep[i]) optimized.push_back(code[i]);
+
+    // ---- 3. REGISTER REMAPPING ----
+    std::array<std::uint16_t, MAX_REGISTER_COUNT> remap {};
+    Registers taken, mapped;
+    for (size_t r {0}; r < register_count; ++r) {
+        if (is_input(r) || r == output) {
+            remap[r] = static_cast<std::uint16_t>(r);
+            taken[r] = mapped[r] = true;
+        }
+    }
+    size_t next_free {0};
+    auto map = [&](size_t r) {
+        if (mapped[r]) return;
+        while (taken[next_free]) ++next_free;
+        remap[r] = static_cast<std::uint16_t>(next_free);
+        taken[next_free] = mapped[r] = true;
+    };
+    for (ExecInstruction const & e : optimized) {
+        reads(e, map);
+        map(e.instr.Ri);
+    }
+    for (ExecInstruction & e : optimized) {
+        Instruction & instr {e.instr};
+        instr.Ri = static_cast<std::uint8_t>(remap[instr.Ri]);
+        instr.Rj = static_cast<std::uint8_t>(remap[instr.Rj]);
+        if (e.kind == Kind::OP && instr.op_type == 1) instr.Rt = static_cast<std::uint8_t>(remap[instr.Rt]);
+        if (e.kind == Kind::OP && instr.Rk_type == RkType::REGISTER) instr.Rk = remap[instr.Rk];
+    }
+
+    // ---- 4. HOISTING ----
+    std::array<size_t, MAX_REGISTER_COUNT> writes {};
+    for (ExecInstruction const & e : optimized) ++writes[e.instr.Ri];
+
+    Registers read_so_far, fixed;
+    for (size_t r {0}; r < register_count; ++r) fixed[r] = writes[r] == 0 && !is_input(r);
+
+    result.code.clear();
+    body.clear();
+    for (ExecInstruction const & e : optimized) {
+        size_t const ri {e.instr.Ri};
+        bool hoist {writes[ri] == 1 && !is_input(ri) && !read_so_far[ri]};
+        if (e.kind == Kind::OP) {
+            OpCode const op {e.instr.op_type == 1 ? GLOBAL_OPERATORS.GetTernaryOpCode(e.instr.op)
+                                                  : GLOBAL_OPERATORS.GetOpCode(e.instr.op)};
+            hoist = hoist && op != OpCode::CUSTOM; // may not be pure
+        }
+        reads(e, [&](size_t r) {
+            hoist = hoist && fixed[r];
+            read_so_far[r] = true;
+        });
+
+        if (hoist) {
+            fixed[ri] = true;
+            result.code.push_back(e);
+        }
+        else body.push_back(e);
+    }
+    result.prologue_size = result.code.size();
+    result.code.insert(result.code.end(), body.begin(), body.end());
+}
+
+template <typename T=double>
+OptimizedCode OptimizeProgram(std::span<Instruction const> instrs,
+    RegisterLayout const & layout, size_t register_count) {
+    OptimizedCode result;
+    OptimizeProgram<T>(instrs, layout, register_count, result);
+    return result;
+}
+
+// 64-bit FNV-1a hash of optimized code. Since OptimizeProgram() drops introns and renumbers
+// registers, programs that only differ in those hash the same (see FitnessCache)
+// 'seed' tells apart things the code doesn't show, like the register type
+inline std::uint64_t HashOptimizedCode(OptimizedCode const & opt, RegisterLayout const & layout,
+    std::uint64_t seed=0) {
+    using Kind = ExecInstruction::Kind;
+    std::uint64_t h {14695981039346656037ull};
+    auto mix = [&](std::uint64_t v) {
+        for (int b {0}; b < 64; b += 8) {
+            h ^= (v >> b) & 0xff;
+            h *= 1099511628211ull;
+        }
+    };
+    mix(seed);
+    mix(layout.input_begin);
+    mix(layout.input_count);
+    mix(layout.output);
+    mix(layout.carry_registers);
+    mix(opt.prologue_size);
+    for (ExecInstruction const & e : opt.code) {
+        Instruction const & instr {e.instr};
+        mix(static_cast<std::uint64_t>(e.kind));
+        mix(instr.Ri);
+        if (e.kind == Kind::LOAD) {
+            mix(std::bit_cast<std::uint64_t>(e.k));
+            continue;
+        }
+        mix(instr.Rj);
+        if (e.kind == Kind::MOVE) continue;
+        mix(instr.op_type);
+        mix(instr.op);
+        if (instr.op_type == 1) mix(instr.Rt);
+        mix(static_cast<std::uint64_t>(instr.Rk_type));
+        // Constants by value, so equal constants from different pool entries match
+        mix(instr.Rk_type == RkType::CONSTANT ? std::bit_cast<std::uint64_t>(e.k) : instr.Rk);
+    }
+    return h;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <random>
+
+// Operators, constants, selectors and variators each keep a generator of their own. When replicate
+// runs go side by side on several threads (see Estimator::ParallelMultiRunEvolve()), they share
+// those objects, so each thread points them at a stream of its own instead.
+class ReplicateStream {
+private:
+    static inline thread_local std::mt19937 * current {nullptr};
+    std::mt19937 * previous;
+
+public:
+    // Draws on this thread go to 'stream' while this is alive
+    ReplicateStream(std::mt19937 & stream) : previous(current) { current = &stream; }
+    ~ReplicateStream() { current = previous; }
+
+    ReplicateStream(ReplicateStream const &) = delete;
+    ReplicateStream & operator=(ReplicateStream const &) = delete;
+
+    // Generator to draw from: this thread's stream if it has one, 'own' otherwise
+    static std::mt19937 & Or(std::mt19937 & own) { return current ? *current : own; }
+};
+
+#endif
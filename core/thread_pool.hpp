@@ -0,0 +1,168 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+// Persistent worker threads for data-parallel loops (see ParallelFor()).
+// Work is split into chunks that are dealt out round-robin to one deque per thread. A thread
+// takes chunks from the back of its own deque and, once that is empty, steals from the front of
+// the others', so threads that drew cheap work (e.g., maze runs that reach the goal early) help
+// out with the rest instead of idling.
+// Each index is processed exactly once and by one thread, so loops that only write their own
+// results give the same results whatever the thread count.
+// A loop doesn't allocate once the queues have grown to fit its chunks, so this can be used from
+// code that is meant to be allocation-free (see AllocationCounter).
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <exception>
+#include <type_traits>
+#include <condition_variable>
+
+#include "emp/base/vector.hpp"
+
+class ThreadPool {
+private:
+    struct Queue {
+        std::mutex m;
+        // [begin, end) index ranges; chunks[front, size) are left, the owner pops from the back
+        // and thieves take from the front. Cleared between loops, so it keeps its storage
+        emp::vector<std::pair<size_t, size_t>> chunks;
+        size_t front {0};
+    };
+
+    emp::vector<std::thread> workers;
+    emp::vector<std::unique_ptr<Queue>> queues; // queues[0] belongs to the calling thread
+
+    // The current loop's body, as a pointer to the caller's callable and a function that calls it
+    // (set before any chunk of a loop is queued; unlike a std::function, it never allocates)
+    void const * body_object {nullptr};
+    void (*body)(void const *, size_t) {nullptr};
+    std::atomic<size_t> remaining {0}; // chunks of the current loop not finished yet
+    std::exception_ptr error; // first exception thrown by 'body'
+
+    std::mutex m;
+    std::condition_variable wake_cv; // new loop, or stopping
+    std::condition_variable done_cv; // current loop finished
+    size_t generation {0};
+    bool stop {false};
+
+    bool Pop(size_t self, std::pair<size_t, size_t> & chunk) {
+        {
+            Queue & own {*queues[self]};
+            std::lock_guard<std::mutex> lock(own.m);
+            if (own.front < own.chunks.size()) {
+                chunk = own.chunks.back();
+                own.chunks.pop_back();
+                return true;
+            }
+        }
+        for (size_t k {1}; k < queues.size(); ++k) {
+            Queue & victim {*queues[(self + k) % queues.size()]};
+            std::lock_guard<std::mutex> lock(victim.m);
+            if (victim.front < victim.chunks.size()) {
+                chunk = victim.chunks[victim.front++];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Runs chunks until there are none left to take
+    void Drain(size_t self) {
+        std::pair<size_t, size_t> chunk;
+        while (Pop(self, chunk)) {
+            try {
+                for (size_t i {chunk.first}; i < chunk.second; ++i) body(body_object, i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(m);
+                if (!error) error = std::current_exception();
+            }
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(m);
+                done_cv.notify_all();
+            }
+        }
+    }
+
+    void WorkerLoop(size_t self) {
+        size_t seen {0};
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m);
+                wake_cv.wait(lock, [&] { return stop || generation != seen; });
+                if (stop) return;
+                seen = generation;
+            }
+            Drain(self);
+        }
+    }
+
+public:
+    // 'threads' counts the calling thread, which works too; 0 means one per hardware thread
+    ThreadPool(size_t threads=0) {
+        if (threads == 0) threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        for (size_t t {0}; t < threads; ++t) queues.push_back(std::make_unique<Queue>());
+        for (size_t t {1}; t < threads; ++t) workers.emplace_back([this, t] { WorkerLoop(t); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stop = true;
+        }
+        wake_cv.notify_all();
+        for (std::thread & w : workers) w.join();
+    }
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool & operator=(ThreadPool const &) = delete;
+
+    size_t Size() const { return queues.size(); }
+
+    // Calls f(i) for every i in [0, n), 'grain' indices per chunk, and returns when all are done
+    // Rethrows the first exception f threw (the other indices still run)
+    // Not reentrant: f must not call ParallelFor() on the same pool
+    template <typename F>
+    void ParallelFor(size_t n, F && f, size_t grain=1) {
+        if (n == 0) return;
+        if (queues.size() == 1) {
+            for (size_t i {0}; i < n; ++i) f(i);
+            return;
+        }
+        grain = std::max<size_t>(grain, 1);
+
+        // 'f' outlives the loop, since this only returns once every chunk is done
+        using Body = std::remove_reference_t<F>;
+        body_object = &f;
+        body = [](void const * object, size_t i) { (*static_cast<Body *>(const_cast<void *>(object)))(i); };
+        error = nullptr;
+        size_t const chunk_count {(n + grain - 1) / grain};
+        remaining = chunk_count;
+        for (std::unique_ptr<Queue> & q : queues) {
+            std::lock_guard<std::mutex> lock(q->m);
+            q->chunks.clear();
+            q->front = 0;
+        }
+        for (size_t c {0}; c < chunk_count; ++c) {
+            Queue & q {*queues[c % queues.size()]};
+            std::lock_guard<std::mutex> lock(q.m);
+            q.chunks.emplace_back(c * grain, std::min(n, (c + 1) * grain));
+        }
+        {
+            std::lock_guard<std::mutex> lock(m);
+            ++generation;
+        }
+        wake_cv.notify_all();
+
+        Drain(0);
+        std::unique_lock<std::mutex> lock(m);
+        done_cv.wait(lock, [&] { return remaining == 0; });
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+#endif
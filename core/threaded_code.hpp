@@ -0,0 +1,172 @@
+#ifndef THREADED_CODE_HPP
+#define THREADED_CODE_HPP
+
+// A program compiled once into a chain of handlers (threaded code).
+// Each instruction becomes a Step holding a pointer to a handler that is specialized for
+// its operator and for whether r[k] is a register or a constant, so running a Step doesn't
+// branch on Rk_type/op_type or go through the operator table. User-registered operators
+// get a generic handler that still calls their std::function.
+// The constant value is copied into the Step, so compiled code doesn't touch GLOBAL_CONSTANTS.
+// CAP is the step capacity, like LinearProgram's L: if nonzero, steps are stored inline (see
+// inline_vector.hpp), so programs can hold their compiled code by value and copy it without allocating.
+
+#include <span>
+#include <cstdint>
+#include <algorithm>
+
+#include "emp/base/vector.hpp"
+
+#include "instructions.hpp"
+#include "peephole.hpp"
+#include "inline_vector.hpp"
+
+template <size_t CAP=0>
+class BasicThreadedCode {
+public:
+    struct Step;
+    using Handler = void (*)(Step const &, double *);
+
+    struct Step {
+        Handler run;
+        double k; // r[k] if it is a constant
+        std::uint16_t Rk; // r[k] if it is a register
+        std::uint8_t op; // only used by user-registered operators
+        std::uint8_t Ri, Rj, Rt;
+    };
+
+private:
+    InlineStorage<Step, CAP> steps;
+    size_t prologue_size {0}; // steps[0, prologue_size) only run in RunPrologue()
+
+    // ---- HANDLERS ----
+
+    template <bool K_CONST>
+    static double RkValue(Step const & s, double const * r) {
+        if constexpr (K_CONST) return s.k;
+        else return r[s.Rk];
+    }
+
+    template <OpCode OP, bool K_CONST>
+    static void Builtin(Step const & s, double * r) {
+        // OP is a template argument, so the switch in ApplyBuiltin() folds away
+        r[s.Ri] = std::clamp(Operators::ApplyBuiltin(OP, r[s.Rj], RkValue<K_CONST>(s, r)), -1e6, 1e6);
+    }
+
+    template <bool K_CONST>
+    static void Custom(Step const & s, double * r) {
+        r[s.Ri] = std::clamp(GLOBAL_OPERATORS.Apply(s.op, r[s.Rj], RkValue<K_CONST>(s, r)), -1e6, 1e6);
+    }
+
+    template <bool K_CONST>
+    static void BuiltinIf3(Step const & s, double * r) {
+        r[s.Ri] = std::clamp(
+            Operators::ApplyBuiltinTernary(OpCode::IF3, r[s.Rj], r[s.Rt], RkValue<K_CONST>(s, r)), -1e6, 1e6);
+    }
+
+    template <bool K_CONST>
+    static void CustomTernary(Step const & s, double * r) {
+        r[s.Ri] = std::clamp(
+            GLOBAL_OPERATORS.ApplyTernary(s.op, r[s.Rj], r[s.Rt], RkValue<K_CONST>(s, r)), -1e6, 1e6);
+    }
+
+    // Only in optimized code (see peephole.hpp)
+    static void Move(Step const & s, double * r) { r[s.Ri] = std::clamp(r[s.Rj], -1e6, 1e6); }
+    static void Load(Step const & s, double * r) { r[s.Ri] = s.k; }
+
+    template <bool K_CONST>
+    static Handler PickHandler(Instruction const & instr) {
+        if (instr.op_type == 1) {
+            if (GLOBAL_OPERATORS.GetTernaryOpCode(instr.op) == OpCode::IF3) return &BuiltinIf3<K_CONST>;
+            return &CustomTernary<K_CONST>;
+        }
+        switch (GLOBAL_OPERATORS.GetOpCode(instr.op)) {
+            case OpCode::ADD: return &Builtin<OpCode::ADD, K_CONST>;
+            case OpCode::SUB: return &Builtin<OpCode::SUB, K_CONST>;
+            case OpCode::MULT: return &Builtin<OpCode::MULT, K_CONST>;
+            case OpCode::DIV: return &Builtin<OpCode::DIV, K_CONST>;
+            case OpCode::AND: return &Builtin<OpCode::AND, K_CONST>;
+            case OpCode::OR: return &Builtin<OpCode::OR, K_CONST>;
+            case OpCode::NAND: return &Builtin<OpCode::NAND, K_CONST>;
+            case OpCode::NOR: return &Builtin<OpCode::NOR, K_CONST>;
+            case OpCode::XOR: return &Builtin<OpCode::XOR, K_CONST>;
+            case OpCode::GREATER: return &Builtin<OpCode::GREATER, K_CONST>;
+            case OpCode::EQUAL: return &Builtin<OpCode::EQUAL, K_CONST>;
+            case OpCode::LESS: return &Builtin<OpCode::LESS, K_CONST>;
+            case OpCode::IF: return &Builtin<OpCode::IF, K_CONST>;
+            case OpCode::NOT: return &Builtin<OpCode::NOT, K_CONST>;
+            default: return &Custom<K_CONST>;
+        }
+    }
+
+public:
+    BasicThreadedCode() = default;
+    // Instructions are assumed to be validated already (see SetInstructions())
+    explicit BasicThreadedCode(std::span<Instruction const> code) { Compile(code); }
+
+    void Compile(std::span<Instruction const> code) {
+        prologue_size = 0;
+        steps.clear();
+        steps.reserve(code.size());
+        for (Instruction const & instr : code) {
+            Step s {};
+            s.op = instr.op;
+            s.Ri = instr.Ri;
+            s.Rj = instr.Rj;
+            s.Rt = instr.Rt;
+            if (instr.Rk_type == RkType::CONSTANT) {
+                s.k = GLOBAL_CONSTANTS.GetConstant(instr.Rk);
+                s.run = PickHandler<true>(instr);
+            }
+            else {
+                s.Rk = instr.Rk;
+                s.run = PickHandler<false>(instr);
+            }
+            steps.push_back(s);
+        }
+    }
+
+    // Compiles the output of OptimizeProgram()
+    void Compile(OptimizedCode const & optimized) {
+        prologue_size = optimized.prologue_size;
+        steps.clear();
+        steps.reserve(optimized.code.size());
+        for (ExecInstruction const & e : optimized.code) {
+            Instruction const & instr {e.instr};
+            Step s {};
+            s.op = instr.op;
+            s.Ri = instr.Ri;
+            s.Rj = instr.Rj;
+            s.Rt = instr.Rt;
+            s.k = e.k;
+            if (e.kind == ExecInstruction::Kind::MOVE) s.run = &Move;
+            else if (e.kind == ExecInstruction::Kind::LOAD) s.run = &Load;
+            else if (instr.Rk_type == RkType::CONSTANT) s.run = PickHandler<true>(instr);
+            else {
+                s.Rk = instr.Rk;
+                s.run = PickHandler<false>(instr);
+            }
+            steps.push_back(s);
+        }
+    }
+
+    // 'registers' must be at least as large as the register file the code was compiled for
+    void Run(double * registers) const {
+        for (size_t i {prologue_size}; i < steps.size(); ++i) steps[i].run(steps[i], registers);
+    }
+
+    // Hoisted instructions (see peephole.hpp), which need to run before Run() once after
+    // the registers are reset
+    void RunPrologue(double * registers) const {
+        for (size_t i {0}; i < prologue_size; ++i) steps[i].run(steps[i], registers);
+    }
+
+    // Room for 'n' steps, so compiling (or copying in) code that long doesn't allocate
+    void Reserve(size_t n) { steps.reserve(n); }
+
+    size_t Size() const { return steps.size(); }
+    size_t PrologueSize() const { return prologue_size; }
+};
+
+using ThreadedCode = BasicThreadedCode<>;
+
+#endif
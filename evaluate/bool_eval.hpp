@@ -0,0 +1,140 @@
+#ifndef BOOL_EVAL_HPP
+#define BOOL_EVAL_HPP
+
+// Boolean problems (parity, multiplexer, ...) over every combination of 'input_count' input bits.
+// Registers are bitsets: bit c of a register word is that register's truth value in fitness case c,
+// so each instruction evaluates 64 cases with one bitwise op.
+// Inputs go in r[1..input_count], the prediction is r[0] (registers start at 0 / false).
+// Only the logic operators (see Operators::RegisterLogicOperators()) and IF-3 are supported;
+// bit-for-bit, they give the same truth values as the double interpreter (Operators::AsBool()).
+// Use Operators(ternary, false) for a logic-only operator set.
+
+#include <bit>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
+#include "emp/base/vector.hpp"
+
+#include "../core/base_eval.hpp"
+
+class BooleanEvaluator final : public Evaluator {
+private:
+    using word = std::uint64_t;
+
+    size_t input_count;
+    size_t case_count; // 2^input_count
+    size_t word_count; // words per register
+    // input_words[i * word_count + w]: input i in cases [64w, 64w + 64)
+    emp::vector<word> input_words;
+    emp::vector<word> target_words;
+    emp::vector<word> valid_words; // masks out unused bits of the last word
+
+    // All ones if the constant is true
+    static word Broadcast(double val) { return Operators::AsBool(val) ? ~word{0} : word{0}; }
+
+    // r[i] = op (r[j] r[k]) (or op (r[j] r[t] r[k]) if ternary) for all words
+    void ExecuteInstruction(Instruction const & instr, word * regs) const {
+        size_t const n {word_count};
+        word const * a {regs + instr.Rj * n};
+        word * out {regs + instr.Ri * n};
+        bool const k_const {instr.Rk_type == RkType::CONSTANT};
+        word const k_word {k_const ? Broadcast(GLOBAL_CONSTANTS.GetConstant(instr.Rk)) : word{0}};
+        word const * b {k_const ? nullptr : regs + instr.Rk * n};
+        auto B = [&](size_t w) { return k_const ? k_word : b[w]; };
+
+        if (instr.op_type == 1) {
+            if (GLOBAL_OPERATORS.GetTernaryOpCode(instr.op) != OpCode::IF3) {
+                throw std::runtime_error("BooleanEvaluator only supports built-in logic operators.");
+            }
+            word const * t {regs + instr.Rt * n};
+            for (size_t w {0}; w < n; ++w) out[w] = (a[w] & t[w]) | (~a[w] & B(w));
+            return;
+        }
+
+        switch (GLOBAL_OPERATORS.GetOpCode(instr.op)) {
+            case OpCode::AND: for (size_t w {0}; w < n; ++w) out[w] = a[w] & B(w); break;
+            case OpCode::OR: for (size_t w {0}; w < n; ++w) out[w] = a[w] | B(w); break;
+            case OpCode::NAND: for (size_t w {0}; w < n; ++w) out[w] = ~(a[w] & B(w)); break;
+            case OpCode::NOR: for (size_t w {0}; w < n; ++w) out[w] = ~(a[w] | B(w)); break;
+            case OpCode::XOR: for (size_t w {0}; w < n; ++w) out[w] = a[w] ^ B(w); break;
+            case OpCode::GREATER: for (size_t w {0}; w < n; ++w) out[w] = a[w] & ~B(w); break;
+            case OpCode::EQUAL: for (size_t w {0}; w < n; ++w) out[w] = ~(a[w] ^ B(w)); break;
+            case OpCode::LESS: for (size_t w {0}; w < n; ++w) out[w] = ~a[w] & B(w); break;
+            case OpCode::IF: for (size_t w {0}; w < n; ++w) out[w] = a[w] & B(w); break; // a ? b : false
+            case OpCode::NOT: for (size_t w {0}; w < n; ++w) out[w] = ~a[w]; break;
+            default:
+                throw std::runtime_error("BooleanEvaluator only supports built-in logic operators.");
+        }
+    }
+
+public:
+    // 'target' gets a case index; bit i of the index is the value of input i
+    BooleanEvaluator(size_t inputs, std::function<bool(std::uint64_t)> target)
+      : input_count(inputs) {
+        if (input_count == 0 || input_count > 30) throw std::runtime_error("Unsupported number of Boolean inputs.");
+        case_count = size_t{1} << input_count;
+        word_count = (case_count + 63) / 64;
+
+        input_words.assign(input_count * word_count, 0);
+        target_words.assign(word_count, 0);
+        valid_words.assign(word_count, 0);
+        for (size_t c {0}; c < case_count; ++c) {
+            word const bit {word{1} << (c % 64)};
+            for (size_t i {0}; i < input_count; ++i) {
+                if ((c >> i) & 1) input_words[i * word_count + c / 64] |= bit;
+            }
+            if (target(c)) target_words[c / 64] |= bit;
+            valid_words[c / 64] |= bit;
+        }
+    }
+
+    // Even parity: true if an even number of inputs are set
+    static BooleanEvaluator EvenParity(size_t inputs) {
+        return BooleanEvaluator(inputs, [](std::uint64_t c) { return std::popcount(c) % 2 == 0; });
+    }
+
+    // The low 'address_bits' inputs select one of the following 2^address_bits data inputs
+    static BooleanEvaluator Multiplexer(size_t address_bits) {
+        return BooleanEvaluator(address_bits + (size_t{1} << address_bits), [address_bits](std::uint64_t c) {
+            std::uint64_t address {c & ((std::uint64_t{1} << address_bits) - 1)};
+            return ((c >> (address_bits + address)) & 1) != 0;
+        });
+    }
+
+    size_t GetCaseCount() const { return case_count; }
+
+    emp::vector<double> GetInputSet() const override {
+        throw std::logic_error("BooleanEvaluator::GetInputSet() is not supported.");
+    }
+
+    // Number of fitness cases where r[0] disagrees with the target
+    size_t CountMismatches(Program & p) const {
+        ArithmeticProgramBase & prog {dynamic_cast<ArithmeticProgramBase&>(p)};
+        size_t const register_count {prog.GetRegisterCount()};
+        if (register_count <= input_count) throw std::runtime_error("Not enough registers for the Boolean inputs.");
+
+        // Laid out as [register][word], reused across calls
+        static thread_local emp::vector<word> regs;
+        regs.assign(register_count * word_count, 0);
+        std::copy(input_words.begin(), input_words.end(), regs.begin() + word_count); // r[1..input_count]
+
+        for (Instruction const & instr : prog.GetEffectiveInstructions()) {
+            ExecuteInstruction(instr, regs.data());
+        }
+
+        size_t mismatches {0};
+        for (size_t w {0}; w < word_count; ++w) {
+            mismatches += std::popcount((regs[w] ^ target_words[w]) & valid_words[w]);
+        }
+        return mismatches;
+    }
+
+    // Negated, since selection maximizes fitness
+    double Evaluate(Program & prog) const override {
+        return -static_cast<double>(CountMismatches(prog));
+    }
+};
+
+#endif
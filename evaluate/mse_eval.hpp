@@ -3,45 +3,273 @@
 
 #include "../core/base_eval.hpp"
 
+#include <bit>
 #include <cmath>
+#include <memory>
 #include <vector>
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
 
-class MSE: public Evaluator {
+class MSE final : public Evaluator {
 private:
     std::function<double(double)> target_func;
     std::vector<double> test_inputs;
+    std::vector<double> test_targets; // target_func(x) for each test input, computed once
     bool use_tanh;
+    // Vectorized mode runs each program over all test inputs at once
+    // (see Program::ExecuteProgramBatch()) instead of one Interpret() call per input
+    bool vectorized;
+    // Blocked mode (EvaluatePopulation() only) tiles the work into blocks of programs x blocks
+    // of cases, so a block of inputs stays in cache while every program in the block runs over it
+    // Disabled when case_block is 0
+    size_t program_block {32};
+    size_t case_block {0};
+    // Incremental mode (vectorized only) keeps up to this many bytes of register snapshots per
+    // program, so children only re-run what changed since their parent (see
+    // Program::ExecuteProgramBatchIncremental()). Disabled when 0
+    size_t snapshot_bytes {0};
+    // Semantic dedup mode (EvaluatePopulation() only) runs every program on a few probe inputs
+    // first, and programs whose probe outputs match all get the fitness of the first of them
+    // (see SetSemanticDedup()). Disabled when probe_inputs is empty
+    std::vector<double> probe_inputs;
+    mutable std::vector<size_t> saved_history; // evaluations skipped, per EvaluatePopulation() call
+    // Prefix-sharing mode (EvaluatePopulation() only) runs the programs together, so instruction
+    // prefixes that several of them share run once (see Program::ExecuteGroupBatch())
+    bool prefix_sharing {false};
+    mutable std::vector<double> compression_history; // instructions executed / naive, per call
+
+    static constexpr size_t lanes {4}; // independent partial sums, so reductions can use vector adds
+
+    // Adds the squared errors of cases [begin, end) to 'partial', given their raw 'outputs'
+    // Case c always goes to partial[c % lanes], so the sums don't depend on how cases are blocked
+    void AccumulateErrors(double * outputs, size_t begin, size_t end, double * partial) const {
+        size_t const n {end - begin};
+        for (size_t i {0}; i < n; ++i) outputs[i] = Postprocess(outputs[i]);
+
+        double const * targets {test_targets.data() + begin};
+        size_t i {0};
+        for (; i < n && (begin + i) % lanes != 0; ++i) {
+            double diff {outputs[i] - targets[i]};
+            partial[(begin + i) % lanes] += diff * diff;
+        }
+        for (; i + lanes <= n; i += lanes) {
+            for (size_t l {0}; l < lanes; ++l) {
+                double diff {outputs[i + l] - targets[i + l]};
+                partial[l] += diff * diff;
+            }
+        }
+        for (; i < n; ++i) {
+            double diff {outputs[i] - targets[i]};
+            partial[(begin + i) % lanes] += diff * diff;
+        }
+    }
+
+    double ReduceErrors(double const * partial) const {
+        return ((partial[0] + partial[1]) + (partial[2] + partial[3])) / test_inputs.size();
+    }
+
+    // Hash of the program's predictions on the probe inputs
+    std::uint64_t Fingerprint(Program & prog) const {
+        static thread_local std::vector<double> outputs;
+        prog.ExecuteProgramBatch(probe_inputs, outputs);
+        std::uint64_t h {14695981039346656037ull}; // FNV-1a
+        for (double out : outputs) {
+            std::uint64_t const bits {std::bit_cast<std::uint64_t>(Postprocess(out))};
+            for (int b {0}; b < 64; b += 8) {
+                h ^= (bits >> b) & 0xff;
+                h *= 1099511628211ull;
+            }
+        }
+        return h;
+    }
+
+    // Fitnesses of population[i] for each i in 'indices', in order, written into 'fitnesses'
+    // Scratch buffers are reused across calls, as are the caller's
+    void EvaluateSubset(std::vector<std::unique_ptr<Program>> const & population,
+        std::vector<size_t> const & indices, std::vector<double> & fitnesses) const {
+        fitnesses.clear();
+        if (prefix_sharing && snapshot_bytes == 0 && !indices.empty()) {
+            EvaluateShared(population, indices, fitnesses);
+            return;
+        }
+        if (case_block == 0 || snapshot_bytes > 0) {
+            for (size_t i : indices) fitnesses.push_back(Evaluate(*population[i]));
+            return;
+        }
+        if (test_inputs.empty()) throw std::runtime_error("No test inputs available.");
+
+        size_t const n {test_inputs.size()};
+        size_t const pop {indices.size()};
+        static thread_local std::vector<double> partials; // per program
+        partials.assign(pop * lanes, 0.0);
+        static thread_local std::vector<double> outputs;
+        outputs.resize(std::min(case_block, n));
+
+        for (size_t p0 {0}; p0 < pop; p0 += program_block) {
+            size_t const p1 {std::min(p0 + program_block, pop)};
+            for (size_t c0 {0}; c0 < n; c0 += case_block) {
+                size_t const c1 {std::min(c0 + case_block, n)};
+                for (size_t p {p0}; p < p1; ++p) {
+                    population[indices[p]]->ExecuteProgramBatch(test_inputs.data() + c0, c1 - c0, outputs.data());
+                    AccumulateErrors(outputs.data(), c0, c1, partials.data() + p * lanes);
+                }
+            }
+        }
+
+        for (size_t p {0}; p < pop; ++p) fitnesses.push_back(ReduceErrors(partials.data() + p * lanes));
+    }
+
+    // EvaluateSubset() in prefix-sharing mode, a block of cases at a time if blocking is on
+    void EvaluateShared(std::vector<std::unique_ptr<Program>> const & population,
+        std::vector<size_t> const & indices, std::vector<double> & fitnesses) const {
+        if (test_inputs.empty()) throw std::runtime_error("No test inputs available.");
+
+        static thread_local std::vector<Program *> group;
+        group.clear();
+        for (size_t i : indices) group.push_back(population[i].get());
+        size_t const n {test_inputs.size()};
+        size_t const block {case_block == 0 ? n : std::min(case_block, n)};
+        static thread_local std::vector<double> partials;
+        partials.assign(group.size() * lanes, 0.0);
+        static thread_local std::vector<double> outputs;
+        outputs.resize(group.size() * block);
+
+        SharedBatchStats total;
+        for (size_t c0 {0}; c0 < n; c0 += block) {
+            size_t const c1 {std::min(c0 + block, n)};
+            SharedBatchStats const stats {group[0]->ExecuteGroupBatch(group, test_inputs.data() + c0, c1 - c0, outputs.data())};
+            total.executed += stats.executed;
+            total.naive += stats.naive;
+            for (size_t p {0}; p < group.size(); ++p) {
+                AccumulateErrors(outputs.data() + p * (c1 - c0), c0, c1, partials.data() + p * lanes);
+            }
+        }
+        if (total.naive > 0) compression_history.push_back(static_cast<double>(total.executed) / total.naive);
+
+        for (size_t p {0}; p < group.size(); ++p) fitnesses.push_back(ReduceErrors(partials.data() + p * lanes));
+    }
 
 public:
     MSE(std::function<double(double)> func,
         std::vector<double> const & inputs,
-        bool tanh=false)
-        : target_func(func), test_inputs(inputs), use_tanh(tanh) { }
+        bool tanh=false,
+        bool vec=false)
+        : target_func(func), test_inputs(inputs), use_tanh(tanh), vectorized(vec) { 
+        for (double x : test_inputs) test_targets.push_back(target_func(x));
+    }
     
+    // case_block = 0 turns blocked mode off
+    void SetBlocking(size_t programs, size_t cases) {
+        assert(programs > 0 && "Program block must not be empty.");
+        program_block = programs;
+        case_block = cases;
+    }
+
+    // snapshot_bytes = 0 turns incremental mode off
+    void SetIncremental(size_t bytes) {
+        snapshot_bytes = bytes;
+        if (bytes > 0) vectorized = true;
+    }
+
+    // Probes are 'probes' test inputs spread evenly over the test set; 0 turns dedup mode off
+    // This is an approximation: two programs that agree on every probe but not on some other
+    // input share a fitness. More probes make that less likely, but cost more per program.
+    // Mostly pays off late in a run, when much of the population computes the same function.
+    void SetSemanticDedup(size_t probes) {
+        probe_inputs.clear();
+        probes = std::min(probes, test_inputs.size());
+        for (size_t p {0}; p < probes; ++p) probe_inputs.push_back(test_inputs[p * test_inputs.size() / probes]);
+    }
+
+    // With dedup on, a program's fitness is whichever member of its probe class was evaluated
+    // first, so it depends on the rest of the population and mustn't be cached
+    bool IsCacheable() const override { return probe_inputs.empty(); }
+
+    // Evaluations skipped by semantic dedup, one entry per EvaluatePopulation() call
+    std::vector<size_t> const & GetSavedEvaluationHistory() const { return saved_history; }
+
+    // Gives exactly the same fitnesses as EvaluateVectorized(); blocking still splits the cases
+    // Incremental mode takes precedence
+    void SetPrefixSharing(bool on) { prefix_sharing = on; }
+    // Instructions executed over what running every program on its own would take (lower is
+    // better), one entry per EvaluatePopulation() call that could share work
+    std::vector<double> const & GetCompressionHistory() const { return compression_history; }
+
     std::vector<double> GetInputSet() const override {
         return test_inputs;
     }
 
-    double Interpret(Program & prog, double x) const {
-        prog.ResetRegisters();
-        prog.Input(x);
-        double output {prog.ExecuteProgram()};
+    // Turns a raw program output into a prediction
+    double Postprocess(double output) const {
         output = use_tanh ? std::tanh(output) : output;
         // NaN still passes through std::clamp as NaN
         // Penalty for overflow (similar to PyshGP)
         return std::isfinite(output) ? std::clamp(output, -1e6, 1e6) : 1e6;
     }
+
+    double Interpret(Program & prog, double x) const {
+        prog.ResetRegisters();
+        prog.Input(x);
+        return Postprocess(prog.ExecuteProgram());
+    }
+
     double Evaluate(Program & prog) const override {
         if (test_inputs.empty()) throw std::runtime_error("No test inputs available.");
+        if (vectorized) return EvaluateVectorized(prog);
+
         double error_sum {0.0};
-        for (double x : test_inputs) {
-            double pred {Interpret(prog, x)};
-            double targ {target_func(x)};
+        for (size_t i {0}; i < test_inputs.size(); ++i) {
+            double pred {Interpret(prog, test_inputs[i])};
+            double targ {test_targets[i]};
             
             error_sum += std::pow(pred-targ, 2);
         }
         return error_sum / test_inputs.size();
     }
+
+    // Same error as the scalar path, up to floating-point summation order
+    double EvaluateVectorized(Program & prog) const {
+        static thread_local std::vector<double> outputs;
+        if (snapshot_bytes > 0) {
+            outputs.resize(test_inputs.size());
+            prog.ExecuteProgramBatchIncremental(test_inputs.data(), test_inputs.size(), outputs.data(), snapshot_bytes);
+        }
+        else prog.ExecuteProgramBatch(test_inputs, outputs);
+
+        double partial[lanes] {0.0, 0.0, 0.0, 0.0};
+        AccumulateErrors(outputs.data(), 0, test_inputs.size(), partial);
+        return ReduceErrors(partial);
+    }
+
+    // In blocked mode, gives exactly the same fitnesses as EvaluateVectorized()
+    // Incremental mode takes precedence, it needs whole batches
+    void EvaluatePopulation(std::vector<std::unique_ptr<Program>> const & population,
+        std::vector<double> & fitnesses) const override {
+        static thread_local std::vector<size_t> reps; // programs that get a full evaluation
+        reps.clear();
+        if (probe_inputs.empty()) {
+            for (size_t i {0}; i < population.size(); ++i) reps.push_back(i);
+            EvaluateSubset(population, reps, fitnesses);
+            return;
+        }
+
+        // Semantic classes, by fingerprint; each one is evaluated through its first member
+        std::unordered_map<std::uint64_t, size_t> class_of; // fingerprint -> position in reps
+        std::vector<size_t> member_class(population.size());
+        for (size_t i {0}; i < population.size(); ++i) {
+            auto [it, inserted] {class_of.try_emplace(Fingerprint(*population[i]), reps.size())};
+            if (inserted) reps.push_back(i);
+            member_class[i] = it->second;
+        }
+        saved_history.push_back(population.size() - reps.size());
+
+        std::vector<double> rep_fitnesses;
+        EvaluateSubset(population, reps, rep_fitnesses);
+        fitnesses.resize(population.size());
+        for (size_t i {0}; i < population.size(); ++i) fitnesses[i] = rep_fitnesses[member_class[i]];
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
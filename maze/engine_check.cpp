@@ -0,0 +1,197 @@
+#include "maze_global.hpp"
+#include "../core/arith_prog.hpp"
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+
+// Runs random programs with the INTERPRETER, THREADED and JIT engines side by side and reports
+// every output that differs. Covers both register layouts: maze programs carry registers between
+// runs (so the hoisted prologue matters), arithmetic programs reset them before each one.
+// Also checks that programs of every register type with the same CanonicalHash() (which the
+// fitness cache trusts) give the same outputs.
+// Exits with 1 on any mismatch, so optimizer changes can be checked with 'make check'.
+
+constexpr size_t CHECK_PROGRAMS = 2000;
+constexpr size_t CHECK_RUNS = 20; // runs per program
+
+// Compared against the INTERPRETER (the JIT falls back to it where it isn't available)
+constexpr std::array<ExecutionEngine, 2> COMPILED_ENGINES {ExecutionEngine::THREADED, ExecutionEngine::JIT};
+constexpr std::array<char const *, 2> ENGINE_NAMES {"THREADED", "JIT"};
+
+bool SameOutput(double a, double b) {
+    return a == b || (std::isnan(a) && std::isnan(b)); // the optimizer may flip the sign of a zero
+}
+
+// Some inputs are whole numbers, so comparisons and IFs take both branches
+double RandomInput(std::mt19937 & rng) {
+    std::uniform_real_distribution<double> dist(-3.0, 3.0);
+    double const x {dist(rng)};
+    return rng() % 3 == 0 ? std::round(x) : x;
+}
+
+// P is a concrete LinearProgram; 'carried' picks the maze-style run sequence
+template <typename P>
+size_t CheckEngines(std::string const & name, size_t rc, size_t pl, bool carried) {
+    std::mt19937 rng(SEED);
+    P source(rc, pl);
+    P interpreted(rc, pl);
+    emp::vector<P> compiled(COMPILED_ENGINES.size(), P(rc, pl)); // one per engine
+    std::array<size_t, COMPILED_ENGINES.size()> mismatches {};
+
+    for (size_t p {0}; p < CHECK_PROGRAMS; ++p) {
+        source.InitProgram();
+        // Assign() is how the Estimator reuses programs, so this also checks recompiling in place
+        interpreted.Assign(source);
+        interpreted.SetExecutionEngine(ExecutionEngine::INTERPRETER);
+        for (size_t e {0}; e < compiled.size(); ++e) {
+            compiled[e].Assign(source);
+            compiled[e].SetExecutionEngine(COMPILED_ENGINES[e]);
+        }
+
+        for (size_t run {0}; run < CHECK_RUNS; ++run) {
+            if (carried) {
+                // Registers only get reset now and then, like between the mazes of an evaluation
+                if (run % 7 == 6) {
+                    interpreted.ResetRegisters();
+                    for (P & prog : compiled) prog.ResetRegisters();
+                }
+                emp::vector<double> inputs(MAZE_LAYOUT.input_count);
+                for (double & x : inputs) x = RandomInput(rng);
+                interpreted.Input(inputs);
+                for (P & prog : compiled) prog.Input(inputs);
+            }
+            else {
+                double const x {RandomInput(rng)};
+                interpreted.ResetRegisters();
+                interpreted.Input(x);
+                for (P & prog : compiled) {
+                    prog.ResetRegisters();
+                    prog.Input(x);
+                }
+            }
+
+            double const expected {interpreted.ExecuteProgram()};
+            for (size_t e {0}; e < compiled.size(); ++e) {
+                double const actual {compiled[e].ExecuteProgram()};
+                if (SameOutput(expected, actual)) continue;
+                if (mismatches[e] == 0) {
+                    std::cout << name << ", " << ENGINE_NAMES[e] << ": program " << p << ", run " << run
+                              << " gave " << actual << " instead of " << expected << "\n";
+                    source.PrintProgram(std::cout);
+                }
+                ++mismatches[e];
+            }
+        }
+    }
+
+    size_t total {0};
+    for (size_t e {0}; e < compiled.size(); ++e) {
+        std::cout << name << ", " << ENGINE_NAMES[e] << ": " << mismatches[e] << " mismatches over "
+                  << CHECK_PROGRAMS * CHECK_RUNS << " runs\n";
+        total += mismatches[e];
+    }
+    return total;
+}
+
+// r[i] = op(r[j], constant)
+Instruction ConstantOp(std::string const & op, size_t ri, size_t rj, double constant) {
+    Instruction instr;
+    instr.op = static_cast<std::uint8_t>(GLOBAL_OPERATORS.GetOperatorID(op));
+    instr.Ri = static_cast<std::uint8_t>(ri);
+    instr.Rj = static_cast<std::uint8_t>(rj);
+    instr.Rk_type = RkType::CONSTANT;
+    instr.Rk = static_cast<std::uint16_t>(GLOBAL_CONSTANTS.GetConstantID(constant));
+    return instr;
+}
+
+// Outputs of 'prog' over the runs in 'inputs' (one input per run, or one set of sensors per run
+// when registers are carried), starting from reset registers
+template <typename P>
+emp::vector<double> RunAll(P & prog, emp::vector<emp::vector<double>> const & inputs, bool carried) {
+    emp::vector<double> outputs;
+    prog.ResetRegisters();
+    for (emp::vector<double> const & in : inputs) {
+        if (carried) prog.Input(in);
+        else {
+            prog.ResetRegisters();
+            prog.Input(in[0]);
+        }
+        outputs.push_back(prog.ExecuteProgram());
+    }
+    return outputs;
+}
+
+// Short programs, so hashes collide often, plus a pair that only differs in how the register
+// type rounds: 1 / 0.5^12 and 2^12 are both 4096 in double, but 0.5^12 underflows to 0 in Fixed
+template <typename P>
+size_t CheckHashes(std::string const & name, bool carried) {
+    std::mt19937 rng(SEED);
+    emp::vector<emp::vector<double>> inputs(CHECK_RUNS);
+    for (emp::vector<double> & in : inputs) {
+        in.resize(MAZE_LAYOUT.input_count);
+        for (double & x : in) x = RandomInput(rng);
+    }
+
+    size_t const out {carried ? MAZE_LAYOUT.output : ARITHMETIC_LAYOUT.output};
+    emp::vector<Instruction> reciprocal {ConstantOp("ADD", 7, 7, 1.0)}, power {ConstantOp("ADD", 7, 7, 1.0)};
+    for (size_t i {0}; i < 12; ++i) {
+        reciprocal.push_back(ConstantOp("MULT", 7, 7, 0.5));
+        power.push_back(ConstantOp("MULT", 7, 7, 2.0));
+    }
+    reciprocal.push_back(ConstantOp("MULT", 8, 8, 0.0)); // r[8] = 0 in every layout
+    reciprocal.push_back(ConstantOp("ADD", 8, 8, 1.0));
+    Instruction divide {ConstantOp("DIV", out, 8, 0.0)};
+    divide.Rk_type = RkType::REGISTER;
+    divide.Rk = 7;
+    reciprocal.push_back(divide);
+    power.push_back(ConstantOp("ADD", out, 7, 0.0));
+
+    P prog(REGISTER_COUNT, 6);
+    std::unordered_map<std::uint64_t, emp::vector<double>> outputs_of;
+    size_t mismatches {0};
+    for (size_t p {0}; p < CHECK_PROGRAMS + 2; ++p) {
+        if (p < 2) prog.SetInstructions(p == 0 ? reciprocal : power);
+        else prog.InitProgram();
+        emp::vector<double> const outputs {RunAll(prog, inputs, carried)};
+        auto [it, inserted] {outputs_of.try_emplace(prog.CanonicalHash(), outputs)};
+        if (inserted) continue;
+        bool same {true};
+        for (size_t r {0}; r < outputs.size(); ++r) same = same && SameOutput(outputs[r], it->second[r]);
+        if (!same) {
+            if (mismatches == 0) {
+                std::cout << name << ": program " << p << " shares its hash with one that computes something else\n";
+                prog.PrintProgram(std::cout);
+            }
+            ++mismatches;
+        }
+    }
+
+    std::cout << name << ": " << mismatches << " hash mismatches over " << CHECK_PROGRAMS + 2
+              << " programs (" << outputs_of.size() << " distinct hashes)\n";
+    return mismatches;
+}
+
+int main() {
+    // Constants that the peephole pass can fold (x + 0, x * 1, ...)
+    for (double c : {0.0, 1.0, -1.0, 0.5, 2.0}) GLOBAL_CONSTANTS.RegisterConstant(c);
+    std::cout << "Seed: " << SEED << "\n";
+
+    size_t mismatches {0};
+    // Carried registers, stored inline and on the heap
+    mismatches += CheckEngines<BasicMazeProgram<double, 16, 32>>("maze (inline)", REGISTER_COUNT, 32, true);
+    mismatches += CheckEngines<MazeProgram>("maze", REGISTER_COUNT, 100, true);
+    // Reset registers
+    mismatches += CheckEngines<BasicArithmeticProgram<double, 16, 32>>("arithmetic (inline)", REGISTER_COUNT, 32, false);
+    mismatches += CheckEngines<ArithmeticProgram>("arithmetic", REGISTER_COUNT, 100, false);
+
+    mismatches += CheckHashes<MazeProgram>("maze hash", true);
+    mismatches += CheckHashes<FloatMazeProgram>("float maze hash", true);
+    mismatches += CheckHashes<FixedMazeProgram>("Fixed maze hash", true);
+    mismatches += CheckHashes<ArithmeticProgram>("arithmetic hash", false);
+    mismatches += CheckHashes<FloatArithmeticProgram>("float arithmetic hash", false);
+    mismatches += CheckHashes<FixedArithmeticProgram>("Fixed arithmetic hash", false);
+
+    return mismatches == 0 ? 0 : 1;
+}
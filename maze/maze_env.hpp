@@ -286,6 +286,10 @@ public:
         position = start;
     }
 
+    void SetRobotPosition(std::pair<int, int> pos) {
+        position = pos;
+    }
+
     void ResetMaze() {
         grid.clear();
     }
@@ -304,44 +308,66 @@ public:
                !IsWall(coord);
     }
 
-    void Step(int action) {
+    // The const methods below take the robot position as an argument instead of using 'position',
+    // so several threads can run robots through the same maze (see MazeEvaluator::SimulateFrom())
+
+    // Position after taking 'action' from 'pos'
+    std::pair<int, int> StepFrom(std::pair<int, int> pos, int action) const {
         // Robot action indices:
         // 0 = up, 1 = down, 2 = left, 3 = right 
-        auto [dr, dc] {moves[action]};
-        std::pair<int, int> new_pos = {position.first + dr, position.second + dc}; 
-        if (CanMove(new_pos)) position = new_pos;
+        // MazeProgramBase::GetOutputStep() can be negative, wrap it around instead of indexing out of bounds
+        int const count {static_cast<int>(moves.size())};
+        auto [dr, dc] {moves[((action % count) + count) % count]};
+        std::pair<int, int> new_pos = {pos.first + dr, pos.second + dc}; 
+        return CanMove(new_pos) ? new_pos : pos;
+    }
+
+    void Step(int action) {
+        position = StepFrom(position, action);
     }
 
     // Sensor data is used as input for the program
     // Based on different sensor inputs, the program decides which action to take
+    void ReadSensors(std::pair<int, int> pos, emp::vector<double> & out) const {
+        out.resize(5);
+        out[0] = IsWall({pos.first - 1, pos.second}) ? 1.0 : 0.0; // up
+        out[1] = IsWall({pos.first + 1, pos.second}) ? 1.0 : 0.0; // down
+        out[2] = IsWall({pos.first, pos.second - 1}) ? 1.0 : 0.0; // left
+        out[3] = IsWall({pos.first, pos.second + 1}) ? 1.0 : 0.0; // right
+        out[4] = GoalAngle(pos);
+    }
+
     void UpdateSensors() {
-        double up {IsWall({position.first - 1, position.second}) ? 1.0 : 0.0};
-        double down {IsWall({position.first + 1, position.second}) ? 1.0 : 0.0};
-        double left {IsWall({position.first, position.second - 1}) ? 1.0 : 0.0};
-        double right {IsWall({position.first, position.second + 1}) ? 1.0 : 0.0};
-        double angle {GetGoalAngle()};
-        sensors = {up, down, left, right, angle};
+        ReadSensors(position, sensors);
     } 
 
     emp::vector<double> GetSensors() const {
         return sensors;
     }
 
-    double GetGoalAngle() const {
-        int dx {goal.second - position.second}; // x is col
-        int dy {goal.first - position.first}; // y is row
+    double GoalAngle(std::pair<int, int> pos) const {
+        int dx {goal.second - pos.second}; // x is col
+        int dy {goal.first - pos.first}; // y is row
 
         double angle {std::atan2(dy, dx)}; // [-pi, pi]
 
         return angle / M_PI; // [-1, 1]
     }
 
-    double GetDistToGoal() const {
-        int dx {goal.second - position.second}; // col
-        int dy {goal.first - position.first}; // row
+    double GetGoalAngle() const {
+        return GoalAngle(position);
+    }
+
+    double DistToGoal(std::pair<int, int> pos) const {
+        int dx {goal.second - pos.second}; // col
+        int dy {goal.first - pos.first}; // row
         return std::hypot(dx, dy);
     }
 
+    double GetDistToGoal() const {
+        return DistToGoal(position);
+    }
+
     bool ReachedGoal() const {
         return position == goal;
     }
@@ -418,4 +444,4 @@ public:
 
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
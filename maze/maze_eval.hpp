@@ -11,12 +11,12 @@
 
 #include "../core/base_eval.hpp"
 
-class MazeEvaluator : public Evaluator {
+class MazeEvaluator final : public Evaluator {
 private:
     size_t max_steps;
     size_t maze_count;
     size_t maze_row, maze_col;
-    mutable emp::vector<MazeEnvironment> train_mazes; // training cases
+    emp::vector<MazeEnvironment> train_mazes; // training cases
     std::mt19937 rng;
 
 public:
@@ -63,21 +63,30 @@ public:
         }
     }
     
-    // Simulate program on a single maze/training case till MAX_STEPS or till goal reached
-    void SimulateSingleMaze(MazeProgram & prog, MazeEnvironment & maze) const {
+    // Simulate program on a single maze/training case from 'pos' till MAX_STEPS or till goal reached,
+    // returns the robot's final position
+    // Leaves 'maze' alone, so different programs can run through the same maze concurrently
+    std::pair<int, int> SimulateFrom(MazeProgramBase & prog, MazeEnvironment const & maze, std::pair<int, int> pos) const {
+        static thread_local emp::vector<double> sensors; // reused, so simulations don't allocate
         for (size_t step {0}; step < max_steps; ++step) {
-            maze.UpdateSensors();
+            maze.ReadSensors(pos, sensors);
 
-            prog.Input(maze.GetSensors());
+            prog.Input(sensors);
             prog.ExecuteProgram();
 
-            maze.Step(prog.GetOutputStep());
+            pos = maze.StepFrom(pos, prog.GetOutputStep());
 
             // Stop when goal is reached?
-            if (maze.GetDistToGoal() == 0) {
-                return; 
+            if (maze.DistToGoal(pos) == 0) {
+                return pos; 
             }
         }
+        return pos;
+    }
+
+    // Same, starting from and updating the maze's own robot position
+    void SimulateSingleMaze(MazeProgramBase & prog, MazeEnvironment & maze) const {
+        maze.SetRobotPosition(SimulateFrom(prog, maze, maze.GetRobotPosition()));
     }
 
     // // Simulate program on each maze in the training set
@@ -91,7 +100,7 @@ public:
 
     // // Simulate program on each maze ine the training set
     // // Evaluate program's behavior (final position, averaged over all training cases)
-    //  std::pair<double, double> EvaluateBehavior(MazeProgram & prog) const {
+    //  std::pair<double, double> EvaluateBehavior(MazeProgramBase & prog) const {
     //     std::pair<double, double> avg_final_pos(0, 0);
 
     //     for (MazeEnvironment & maze : train_mazes) {
@@ -120,7 +129,7 @@ public:
     // // then average them to get the program's fitness value. 
     // // The smaller the value, the better (before invert)
     // double Evaluate(Program & p) const override {
-    //     MazeProgram & prog = dynamic_cast<MazeProgram&>(p);
+    //     MazeProgramBase & prog = dynamic_cast<MazeProgramBase&>(p);
     //     // Simulate and evaluate p's behavior
     //     EvaluateBehavior(prog);
 
@@ -139,21 +148,18 @@ public:
 
 
     // Evaluate program's behavior (final position, averaged over all training cases)
-    std::pair<double, double> EvaluateBehavior(MazeProgram & prog) const {
+    std::pair<double, double> EvaluateBehavior(MazeProgramBase & prog) const {
         std::pair<double, double> avg_final_pos(0, 0);
 
-        for (MazeEnvironment & maze : train_mazes) {
-            maze.ResetRobotPosition();
-
-            SimulateSingleMaze(prog, maze);
+        for (MazeEnvironment const & maze : train_mazes) {
+            std::pair<int, int> const final_pos {SimulateFrom(prog, maze, maze.GetStartPosition())};
 
             // Get final position of robot in maze
-            avg_final_pos.first += maze.GetRobotPosition().first; // row
-            avg_final_pos.second += maze.GetRobotPosition().second; // col
+            avg_final_pos.first += final_pos.first; // row
+            avg_final_pos.second += final_pos.second; // col
 
             // Between mazes/training cases, reset program registers
             prog.ResetRegisters();
-            maze.ResetRobotPosition();
         }
 
         avg_final_pos.first /= maze_count;
@@ -167,15 +173,12 @@ public:
 
 
     double Evaluate(Program & p) const override {
-        MazeProgram & prog {dynamic_cast<MazeProgram&>(p)};
+        MazeProgramBase & prog {dynamic_cast<MazeProgramBase&>(p)};
 
         double avg_dist {0};
-        for (MazeEnvironment & maze : train_mazes) {
-            maze.ResetRobotPosition();  
-            SimulateSingleMaze(prog, maze);
-            avg_dist += maze.GetDistToGoal(); 
+        for (MazeEnvironment const & maze : train_mazes) {
+            avg_dist += maze.DistToGoal(SimulateFrom(prog, maze, maze.GetStartPosition())); 
             prog.ResetRegisters();
-            maze.ResetRobotPosition();
         }
         avg_dist /= maze_count;
     
@@ -185,15 +188,12 @@ public:
 
     // Store all distances, not averaged
     emp::vector<double> EvaluatePerMaze(Program & p) const {
-        MazeProgram & prog = dynamic_cast<MazeProgram&>(p);
+        MazeProgramBase & prog = dynamic_cast<MazeProgramBase&>(p);
         emp::vector<double> distances;
     
-        for (MazeEnvironment & maze : train_mazes) {
-            maze.ResetRobotPosition();
-            SimulateSingleMaze(prog, maze);
-            distances.push_back(maze.GetDistToGoal());
+        for (MazeEnvironment const & maze : train_mazes) {
+            distances.push_back(maze.DistToGoal(SimulateFrom(prog, maze, maze.GetStartPosition())));
             prog.ResetRegisters();
-            maze.ResetRobotPosition();
         }
     
         return distances;
@@ -239,4 +239,4 @@ public:
 
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -41,6 +41,7 @@ Operators GLOBAL_OPERATORS(true); // ternary operators are enabled
 
 #include "../variate/simple_mutate.hpp"
 #include "../variate/simple_xover.hpp"
+#include "../variate/effective_mutate.hpp"
 
 #include "../select/tour_select.hpp"
 
@@ -50,4 +51,4 @@ Operators GLOBAL_OPERATORS(true); // ternary operators are enabled
 
 #include "../core/estimator.hpp"
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -13,12 +13,12 @@
 
 #include "../core/base_eval.hpp"
 
-class MazeNoveltyEvaluator : public Evaluator {
+class MazeNoveltyEvaluator final : public Evaluator {
 private:
     size_t max_steps;
     size_t maze_count;
     size_t maze_row, maze_col;
-    mutable emp::vector<MazeEnvironment> train_mazes; // training cases
+    emp::vector<MazeEnvironment> train_mazes; // training cases
 
     emp::vector<std::pair<double, double>> other_behaviors;
     size_t k; // number of neighbors for novelty calculation
@@ -58,26 +58,38 @@ public:
         }
     }
 
+    // Novelty depends on the other behaviors
+    bool IsCacheable() const override { return false; }
+
     // Must be called before Evaluate()
     void SetOtherBehaviors(emp::vector<std::pair<double, double>> const & ob) {
         other_behaviors = ob;
     }
     
-    // Simulate program on a single maze/training case till MAX_STEPS or till goal reached
-    void SimulateSingleMaze(MazeProgram & prog, MazeEnvironment & maze) const {
+    // Simulate program on a single maze/training case from 'pos' till MAX_STEPS or till goal reached,
+    // returns the robot's final position
+    // Leaves 'maze' alone, so different programs can run through the same maze concurrently
+    std::pair<int, int> SimulateFrom(MazeProgramBase & prog, MazeEnvironment const & maze, std::pair<int, int> pos) const {
+        static thread_local emp::vector<double> sensors; // reused, so simulations don't allocate
         for (size_t step {0}; step < max_steps; ++step) {
-            maze.UpdateSensors();
+            maze.ReadSensors(pos, sensors);
 
-            prog.Input(maze.GetSensors());
+            prog.Input(sensors);
             prog.ExecuteProgram();
 
-            maze.Step(prog.GetOutputStep());
+            pos = maze.StepFrom(pos, prog.GetOutputStep());
 
             // Stop when goal is reached?
-            if (maze.GetDistToGoal() == 0) {
-                return; 
+            if (maze.DistToGoal(pos) == 0) {
+                return pos; 
             }
         }
+        return pos;
+    }
+
+    // Same, starting from and updating the maze's own robot position
+    void SimulateSingleMaze(MazeProgramBase & prog, MazeEnvironment & maze) const {
+        maze.SetRobotPosition(SimulateFrom(prog, maze, maze.GetRobotPosition()));
     }
 
 
@@ -88,20 +100,18 @@ public:
     }
 
     // Evaluate program's behavior (final position, averaged over all training cases)
-    std::pair<double, double> EvaluateBehavior(MazeProgram & prog) const {
+    std::pair<double, double> EvaluateBehavior(MazeProgramBase & prog) const {
         std::pair<double, double> avg_final_pos(0, 0);
 
-        for (MazeEnvironment & maze : train_mazes) {
-            maze.ResetRobotPosition();
-            SimulateSingleMaze(prog, maze);
+        for (MazeEnvironment const & maze : train_mazes) {
+            std::pair<int, int> const final_pos {SimulateFrom(prog, maze, maze.GetStartPosition())};
 
             // Get final position of robot in maze
-            avg_final_pos.first += maze.GetRobotPosition().first; // row
-            avg_final_pos.second += maze.GetRobotPosition().second; // col
+            avg_final_pos.first += final_pos.first; // row
+            avg_final_pos.second += final_pos.second; // col
 
             // Between mazes/training cases, reset program registers
             prog.ResetRegisters();
-            maze.ResetRobotPosition();
         }
 
         avg_final_pos.first /= maze_count;
@@ -117,13 +127,14 @@ public:
         // its k-closest neighbors in the population and archive (concatenated)
     double Evaluate(Program & p) const override {
         assert(!other_behaviors.empty() && "Cannot compute novelty: behavior set is empty.");
-        MazeProgram & prog = dynamic_cast<MazeProgram&>(p);
+        MazeProgramBase & prog = dynamic_cast<MazeProgramBase&>(p);
         assert(prog.IsBehaviorEvaluated() && "Program behavior has not been evaluated yet.");
 
         // ------ OLD ------
         // Calculate behavioral distances between current program and 
         // others in the population and archive
-        emp::vector<double> distances;
+        static thread_local emp::vector<double> distances; // reused across calls
+        distances.clear();
         for (std::pair<double, double> const & neighbor : other_behaviors) {
             distances.emplace_back(BehaviorDistance(prog.GetBehavior(), neighbor));
         }
@@ -166,4 +177,4 @@ public:
 };
 
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -12,7 +12,7 @@ int main() {
     variators.emplace_back(std::make_unique<SimpleCrossover>(XOVER_RATE));
     variators.emplace_back(std::make_unique<SimpleMutate>(MUT_RATE));
     std::unique_ptr<Selector> selector {std::make_unique<TournamentSelect>()};
-    std::unique_ptr<Program> prototype {std::make_unique<MazeProgram>()};
+    std::unique_ptr<Program> prototype {MakeMazeProgram()}; // stored inline, clones don't allocate
     
     // // ---- OBJECTIVE SEARCH ----
     // // Up to 11 DFS-generated mazes (43x43) are used in the training set, filtered for misdirection/deception.
@@ -131,6 +131,7 @@ int main() {
         MazeProgram prog;
 
         prog.LoadMazeProgram(filename + std::to_string(i) + ".txt");
+        prog.SetExecutionEngine(ExecutionEngine::JIT); // runs on every test maze, worth compiling natively
         std::cout << prog << std::endl;
 
         ofs << i << ",";
@@ -183,4 +184,4 @@ bool MazeAlreadyExists(std::vector<MazeEnvironment> const & vec, MazeEnvironment
             m.GetGoalPosition() == maze.GetGoalPosition()) return true;
     }
     return false;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -1,12 +1,14 @@
 #ifndef TOUR_SELECT_HPP
 #define TOUR_SELECT_HPP
 
+#include <span>
 #include <random>
 #include <memory>
 
 #include "../core/base_select.hpp"
+#include "../core/random.hpp"
 
-class TournamentSelect : public Selector {
+class TournamentSelect final : public Selector {
 private:
     size_t tournament_size;
     std::mt19937 mutable rng;
@@ -14,19 +16,27 @@ public:
     TournamentSelect() : tournament_size(TOUR_SIZE), rng(SEED) { }
     TournamentSelect(size_t tour_size) : tournament_size(tour_size), rng(SEED) { }
 
-    Program const & Select(std::vector<std::unique_ptr<Program>> const & pop) const override {
-        // Randomly pick 'tournament_size' individuals, return best one
-        std::uniform_int_distribution<size_t> dist(0, pop.size() - 1);
+    size_t Select(PopulationColumns const & pop) const override {
+        size_t winner;
+        SelectBatch(pop, std::span<size_t>(&winner, 1));
+        return winner;
+    }
+
+    void SelectBatch(PopulationColumns const & pop, std::span<size_t> out) const override {
+        // Randomly pick 'tournament_size' individuals, keep the best one (the first drawn on ties)
+        std::uniform_int_distribution<size_t> dist(0, pop.Size() - 1);
+        std::mt19937 & gen {ReplicateStream::Or(rng)};
+        double const * fitness {pop.fitness.data()};
 
-        Program const * best {nullptr};
-        for (size_t i {0}; i < tournament_size; ++i) {
-            std::unique_ptr<Program> const & candidate {pop[dist(rng)]};
-            if (!best || best->GetFitness() < candidate->GetFitness()) {
-                best = &(*candidate); // address to the Program object under the smart pointer
+        for (size_t & winner : out) {
+            size_t best {dist(gen)};
+            for (size_t i {1}; i < tournament_size; ++i) {
+                size_t const candidate {dist(gen)};
+                if (fitness[best] < fitness[candidate]) best = candidate;
             }
+            winner = best;
         }
-        return *best;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
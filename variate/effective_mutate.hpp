@@ -0,0 +1,96 @@
+/*
+Mutate a few instructions, picked among the effective ones
+Mutations that land in structural introns can't change the phenotype,
+so they waste an evaluation (see Estimator::IsNeutralChild())
+*/
+
+#ifndef EFFECTIVE_MUTATE_HPP
+#define EFFECTIVE_MUTATE_HPP
+
+#include <cassert>
+#include <random>
+#include <vector>
+#include <memory>
+
+#include "../core/base_vari.hpp"
+#include "../core/random.hpp"
+#include "../core/linear_prog.hpp"
+#include "simple_mutate.hpp"
+
+class EffectiveMutate final : public Variator {
+private:
+    size_t site_count; // instructions mutated per child
+    double intron_prob; // chance that a site is picked among the introns instead (neutral drift)
+    std::mt19937 mutable rng;
+
+public:
+    EffectiveMutate(size_t sites=1, double intron_p=0.05)
+        : site_count(sites), intron_prob(intron_p), rng(SEED) { }
+
+    VariatorType Type() const override { return VariatorType::UNARY; }
+    using Variator::ApplyTracked;
+    using Variator::ApplyInPlace;
+
+    std::unique_ptr<Program> Apply(Program const & prog) const override {
+        emp::vector<size_t> changed;
+        return ApplyTracked(prog, changed);
+    }
+
+    std::unique_ptr<Program> ApplyTracked(Program const & prog, emp::vector<size_t> & changed) const override {
+        // Clone() to make sure 'child' has same derived class as 'prog'
+        std::unique_ptr<Program> child {prog.Clone()};
+        ApplyInPlace(*child, changed);
+        return child;
+    }
+
+    void ApplyInPlace(Program & child, emp::vector<size_t> & changed) const override {
+        std::uniform_real_distribution<double> prob_dist(0.0, 1.0);
+        // The child's own register count, which needn't be REGISTER_COUNT (see MakeMazeProgram())
+        size_t const register_count {dynamic_cast<LinearProgramBase const &>(child).GetRegisterCount()};
+        std::uniform_int_distribution<size_t> reg_dist(0, register_count - 1);
+        std::mt19937 & gen {ReplicateStream::Or(rng)};
+
+        std::span<Instruction> instructions {child.EditInstructions()};
+
+        // Sites are picked from the parent's liveness analysis (see FindEffectiveInstructions()),
+        // which the child still carries at this point
+        static thread_local std::vector<size_t> effective, introns;
+        effective.clear();
+        introns.clear();
+        for (size_t i {0}; i < instructions.size(); ++i) {
+            if (child.IsEffectiveInstruction(i)) effective.push_back(i);
+            else introns.push_back(i);
+        }
+
+        for (size_t s {0}; s < site_count && !instructions.empty(); ++s) {
+            bool const pick_intron {effective.empty() || (!introns.empty() && prob_dist(gen) < intron_prob)};
+            std::vector<size_t> const & pool {pick_intron ? introns : effective};
+            size_t const i {pool[std::uniform_int_distribution<size_t>(0, pool.size() - 1)(gen)]};
+            Instruction & instr {instructions[i]};
+            Instruction const before {instr};
+
+            // Mutate one field: operator, Ri, Rj, Rt (ternary only) or Rk
+            size_t const field_count {instr.op_type == 1 ? 5u : 4u};
+            switch (std::uniform_int_distribution<size_t>(0, field_count - 1)(gen)) {
+                case 0: SimpleMutate::MutateOperator(instr, gen, register_count); break;
+                case 1: instr.Ri = reg_dist(gen); break;
+                case 2: instr.Rj = reg_dist(gen); break;
+                case 3: SimpleMutate::MutateRk(instr, gen, register_count); break;
+                case 4: instr.Rt = reg_dist(gen); break;
+            }
+
+            if (!(instr == before)) changed.push_back(i);
+        }
+
+        child.CommitInstructions();
+        child.ResetFitness();
+        child.ResetRegisters();
+    }
+
+    std::unique_ptr<Program> Apply(Program const &, Program const &) const override {
+        assert(false && "EffectiveMutate is not a binary operator.");
+        return std::unique_ptr<Program>();
+    }
+};
+
+#endif
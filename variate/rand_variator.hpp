@@ -6,7 +6,7 @@
 
 #include "../core/base_vari.hpp"
 
-class RandomVariator: public Variator {
+class RandomVariator final : public Variator {
 private:
     std::mt19937 mutable rng;
 
@@ -25,4 +25,4 @@ public:
     }
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
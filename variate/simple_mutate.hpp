@@ -12,8 +12,9 @@ Mutate each part of instruction with equal probability
 #include <memory>
 
 #include "../core/base_vari.hpp"
+#include "../core/random.hpp"
 
-class SimpleMutate: public Variator {
+class SimpleMutate final : public Variator {
 private:
     double mutation_rate;
     std::mt19937 mutable rng;
@@ -21,72 +22,96 @@ public:
     SimpleMutate(double rate) : mutation_rate(rate), rng(SEED) { }
 
     VariatorType Type() const override { return VariatorType::UNARY; }
+    using Variator::ApplyTracked;
+    using Variator::ApplyInPlace;
     
+    // Field mutations, shared with other mutation operators (see EffectiveMutate)
+    // New register operands are drawn from [0, register_count)
+    static void MutateOperator(Instruction & instr, std::mt19937 & rng, size_t register_count) {
+        std::uniform_real_distribution<double> prob_dist(0.0, 1.0);
+        std::uniform_int_distribution<size_t> reg_dist(0, register_count - 1);
+        if (prob_dist(rng) < 0.5 || GLOBAL_OPERATORS.TernarySize() == 0) {
+            instr.op = GLOBAL_OPERATORS.GetRandomOpID();
+            instr.op_type = 0;
+            instr.Rt = 0; // unused by unary/binary operators
+        }
+        else {
+            // if we're switching from unary/binary to ternary, Rt is unused so far
+            if (instr.op_type == 0) { 
+                instr.Rt = reg_dist(rng);
+            }
+            instr.op = GLOBAL_OPERATORS.GetRandomTernaryOpID();
+            instr.op_type = 1;
+        }
+    }
+
+    static void MutateRk(Instruction & instr, std::mt19937 & rng, size_t register_count) {
+        std::uniform_real_distribution<double> prob_dist(0.0, 1.0);
+        std::uniform_int_distribution<size_t> reg_dist(0, register_count - 1);
+        if (instr.Rk_type == RkType::CONSTANT) {
+            if (prob_dist(rng) < 0.5 && GLOBAL_CONSTANTS.Size() > 0) {
+                instr.Rk = GLOBAL_CONSTANTS.GetRandomConstantID();
+            }
+            else {
+                instr.Rk_type = RkType::REGISTER;
+                instr.Rk = reg_dist(rng);
+            }
+        }
+        else {
+            if (prob_dist(rng) < 0.5) {
+                instr.Rk = reg_dist(rng);
+            }
+            else if (GLOBAL_CONSTANTS.Size() > 0) {
+                instr.Rk_type = RkType::CONSTANT;
+                instr.Rk = GLOBAL_CONSTANTS.GetRandomConstantID();
+            }
+        }
+    }
+
     std::unique_ptr<Program> Apply(Program const & prog) const override {
+        emp::vector<size_t> changed;
+        return ApplyTracked(prog, changed);
+    }
+
+    std::unique_ptr<Program> ApplyTracked(Program const & prog, emp::vector<size_t> & changed) const override {
+        // Clone() to make sure 'child' has same derived class as 'prog'
+        std::unique_ptr<Program> child {prog.Clone()}; 
+        ApplyInPlace(*child, changed);
+        return child;
+    }
+
+    void ApplyInPlace(Program & child, emp::vector<size_t> & changed) const override {
         std::uniform_real_distribution<double> prob_dist(0.0, 1.0);
         std::uniform_int_distribution<size_t> reg_dist(0, REGISTER_COUNT - 1);
+        std::mt19937 & gen {ReplicateStream::Or(rng)};
 
-        std::vector<Instruction> instructions = prog.GetInstructions();
-
-        for (Instruction & instr : instructions) {
-            // Mutate operator (unary/binary OR ternary)
-            if (prob_dist(rng) < mutation_rate) {
-                if (prob_dist(rng) < 0.5) {
-                    instr.op = GLOBAL_OPERATORS.GetRandomOpID();
-                    instr.op_type = 0;
-                    instr.Rt.reset();
-                }
-                else {
-                    instr.op = GLOBAL_OPERATORS.GetRandomTernaryOpID();
-                    instr.op_type = 1;
-                    // if we're switching from unary/binary to ternary, Rt is uninitialized
-                    if (!instr.Rt.has_value()) { 
-                        instr.Rt = reg_dist(rng);
-                    }
-                }
-                
-            }
+        std::span<Instruction> instructions {child.EditInstructions()};
+
+        for (size_t i {0}; i < instructions.size(); ++i) {
+            Instruction & instr {instructions[i]};
+            Instruction const before {instr};
+
+            // Mutate operator (unary/binary OR ternary, if there are any ternary operators)
+            if (prob_dist(gen) < mutation_rate) MutateOperator(instr, gen, REGISTER_COUNT);
 
             // Mutate destination register
-            if (prob_dist(rng) < mutation_rate) instr.Ri = reg_dist(rng);
+            if (prob_dist(gen) < mutation_rate) instr.Ri = reg_dist(gen);
 
             // Mutate operand (j - register only)
-            if (prob_dist(rng) < mutation_rate) instr.Rj = reg_dist(rng);
+            if (prob_dist(gen) < mutation_rate) instr.Rj = reg_dist(gen);
 
             // Mutate operand (t - register only, only for ternary)
-            if (instr.op_type == 1 && instr.Rt.has_value() && 
-                prob_dist(rng) < mutation_rate) instr.Rt = reg_dist(rng);
+            if (instr.op_type == 1 && prob_dist(gen) < mutation_rate) instr.Rt = reg_dist(gen);
 
             // Mutate operand (k - register OR constant)
-            if (prob_dist(rng) < mutation_rate) {
-                if (instr.Rk_type == RkType::CONSTANT) {
-                    if (prob_dist(rng) < 0.5 && GLOBAL_CONSTANTS.Size() > 0) {
-                        instr.Rk = GLOBAL_CONSTANTS.GetRandomConstant();
-                    }
-                    else {
-                        instr.Rk_type = RkType::REGISTER;
-                        instr.Rk = reg_dist(rng);
-                    }
-                }
-                else {
-                    if (prob_dist(rng) < 0.5) {
-                        instr.Rk = reg_dist(rng);
-                    }
-                    else if (GLOBAL_CONSTANTS.Size() > 0) {
-                        instr.Rk_type = RkType::CONSTANT;
-                        instr.Rk = GLOBAL_CONSTANTS.GetRandomConstant();
-                    }
-                }
-            }
-        }
+            if (prob_dist(gen) < mutation_rate) MutateRk(instr, gen, REGISTER_COUNT);
 
-        // Clone() to make sure 'child' has same derived class as 'prog'
-        std::unique_ptr<Program> child {prog.Clone()}; 
-        child->SetInstructions(instructions);
-        child->ResetFitness();
-        child->ResetRegisters();
-        return child;
+            if (!(instr == before)) changed.push_back(i);
+        }
 
+        child.CommitInstructions();
+        child.ResetFitness();
+        child.ResetRegisters();
     }
     
     std::unique_ptr<Program> Apply(Program const &, Program const &) const override {
@@ -95,4 +120,4 @@ public:
     }
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
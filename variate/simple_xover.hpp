@@ -12,15 +12,78 @@ Swap each part of instruction with equal probability
 #include <memory>
 
 #include "../core/base_vari.hpp"
+#include "../core/random.hpp"
 
-class SimpleCrossover: public Variator {
+class SimpleCrossover final : public Variator {
 private:
     double xover_rate;
+    bool siblings; // see MakesSiblings()
     std::mt19937 mutable rng;
+
+    // Which fields of an instruction the child takes from the second parent
+    struct Choice {
+        bool op {false}, Ri {false}, Rj {false}, Rt {false}, Rk {false};
+    };
+
+    // Fields are drawn in order; Rt is only drawn when both instructions are ternary
+    Choice Draw(Instruction const & a, Instruction const & b, std::mt19937 & gen) const {
+        std::uniform_real_distribution<double> prob_dist(0.0, 1.0);
+        Choice c;
+        c.op = prob_dist(gen) < xover_rate;
+        c.Ri = prob_dist(gen) < xover_rate;
+        c.Rj = prob_dist(gen) < xover_rate;
+        if (a.op_type == 1 && b.op_type == 1) c.Rt = prob_dist(gen) < xover_rate;
+        c.Rk = prob_dist(gen) < xover_rate;
+        return c;
+    }
+
+    // Instruction of the child of 'a' and 'b' for choice 'c'
+    // Combine(b, a, c) is the sibling's: it takes from 'a' whatever the child took from 'b'
+    static Instruction Combine(Instruction const & a, Instruction const & b, Choice const & c) {
+        Instruction temp;
+        // Choose operator
+        temp.op = c.op ? b.op : a.op;
+        temp.op_type = c.op ? b.op_type : a.op_type;
+
+        // Choose destination register
+        temp.Ri = c.Ri ? b.Ri : a.Ri;
+
+        // Choose operand (j - register only)
+        temp.Rj = c.Rj ? b.Rj : a.Rj;
+
+        // Choose operand (t - register only, only for ternary operators)
+        if (a.op_type == 1 && b.op_type == 1 && temp.op_type == 1) {
+            // If both instructions are ternary
+            temp.Rt = c.Rt ? b.Rt : a.Rt;
+        }
+        else if (a.op_type == 1 && b.op_type == 0 && temp.op_type == 1) {
+            // If only instruction a is ternary
+            temp.Rt = a.Rt;
+        }
+        else if (b.op_type == 1 && a.op_type == 0 && temp.op_type == 1) {
+            // If only instruction b is ternary
+            temp.Rt = b.Rt;
+        }
+
+        // Choose operand (k - register OR constant)
+        temp.Rk_type = c.Rk ? b.Rk_type : a.Rk_type;
+        temp.Rk = c.Rk ? b.Rk : a.Rk;
+        return temp;
+    }
+
+    static void Finish(Program & child) {
+        child.CommitInstructions();
+        child.ResetFitness();
+        child.ResetRegisters();
+    }
+
 public:
-    SimpleCrossover(double rate) : xover_rate(rate), rng(SEED) { }
+    // With 'sib', the estimator gets two complementary children per pair of parents
+    SimpleCrossover(double rate, bool sib=false) : xover_rate(rate), siblings(sib), rng(SEED) { }
 
     VariatorType Type() const override { return VariatorType::BINARY; }
+    using Variator::ApplyTracked;
+    using Variator::ApplyInPlace;
     
     std::unique_ptr<Program> Apply(Program const & ) const override {
         assert(false && "SimpleCrossover is not a unary operator.");
@@ -28,71 +91,58 @@ public:
     }
 
     std::unique_ptr<Program> Apply(Program const & p1, Program const & p2) const override {
-        // we'll just assume p1 and p2 have the same derived class...
-        std::uniform_real_distribution<double> prob_dist(0.0, 1.0);
+        emp::vector<size_t> changed;
+        return ApplyTracked(p1, p2, changed);
+    }
+
+    std::unique_ptr<Program> ApplyTracked(Program const & p1, Program const & p2,
+        emp::vector<size_t> & changed) const override {
+        std::unique_ptr<Program> child {p1.Clone()};
+        ApplyInPlace(*child, p2, changed);
+        return child;
+    }
 
-        std::vector<Instruction> instr1 = p1.GetInstructions();
-        std::vector<Instruction> instr2 = p2.GetInstructions();
+    // we'll just assume both parents have the same derived class...
+    void ApplyInPlace(Program & child, Program const & other, emp::vector<size_t> & changed) const override {
+        std::mt19937 & gen {ReplicateStream::Or(rng)};
+        std::span<Instruction> instr1 {child.EditInstructions()};
+        std::span<Instruction const> instr2 {other.ViewInstructions()};
 
         assert (instr1.size() == instr2.size() &&
          "Programs must have same number of instructions for crossover.");
 
-        std::vector<Instruction> child_instr;
-
         for (size_t i {0}; i < instr1.size(); ++i) {
-            Instruction const & a {instr1[i]};
+            Instruction const a {instr1[i]};
             Instruction const & b {instr2[i]};
-            
-            Instruction temp;
-            // Choose operator
-            if (prob_dist(rng) < xover_rate) {
-                temp.op = b.op;
-                temp.op_type = b.op_type;
-            }
-            else {
-                temp.op = a.op;
-                temp.op_type = a.op_type;
-            }
-
-            // Choose destination register
-            temp.Ri = (prob_dist(rng) < xover_rate) ? b.Ri : a.Ri;
-
-            // Choose operand (j - register only)
-            temp.Rj = (prob_dist(rng) < xover_rate) ? b.Rj : a.Rj;
-
-            // Choose operand (t - register only, only for ternary operators)
-            if (a.op_type == 1 && b.op_type == 1 && temp.op_type == 1) {
-                // If both instructions are ternary
-                temp.Rt = (prob_dist(rng) < xover_rate) ? b.Rt : a.Rt;
-            }
-            else if (a.op_type == 1 && b.op_type == 0 && temp.op_type == 1) {
-                // If only instruction a is ternary
-                temp.Rt = a.Rt;
-            }
-            else if (b.op_type == 1 && a.op_type == 0 && temp.op_type == 1) {
-                // If only instruction b is ternary
-                temp.Rt = b.Rt;
-            }
-
-            // Choose operand (k - register OR constant)
-            if (prob_dist(rng) < xover_rate) {
-                temp.Rk_type = b.Rk_type;
-                temp.Rk = b.Rk;
-            }
-            else {
-                temp.Rk_type = a.Rk_type;
-                temp.Rk = a.Rk;
-            }
-
-            child_instr.push_back(temp);
+            instr1[i] = Combine(a, b, Draw(a, b, gen));
+            if (!(instr1[i] == a)) changed.push_back(i);
         }
+        Finish(child);
+    }
 
-        std::unique_ptr<Program> child {p1.Clone()};
-        child->SetInstructions(child_instr);
-        child->ResetFitness();
-        child->ResetRegisters();
-        return child;
+    bool MakesSiblings() const override { return siblings; }
+
+    void ApplyInPlace(Program & child, Program & sibling,
+        emp::vector<size_t> & changed, emp::vector<size_t> & sibling_changed) const override {
+        std::mt19937 & gen {ReplicateStream::Or(rng)};
+        std::span<Instruction> instr1 {child.EditInstructions()};
+        std::span<Instruction> instr2 {sibling.EditInstructions()};
+
+        assert (instr1.size() == instr2.size() &&
+         "Programs must have same number of instructions for crossover.");
+
+        for (size_t i {0}; i < instr1.size(); ++i) {
+            Instruction const a {instr1[i]};
+            Instruction const b {instr2[i]};
+            Choice const c {Draw(a, b, gen)};
+            instr1[i] = Combine(a, b, c);
+            instr2[i] = Combine(b, a, c);
+            if (!(instr1[i] == a)) changed.push_back(i);
+            if (!(instr2[i] == b)) sibling_changed.push_back(i);
+        }
+        Finish(child);
+        Finish(sibling);
     }
 };
 
-#endif
\ No newline at end of file
+#endif